@@ -0,0 +1,251 @@
+// Plays games with a solver and no user interface.
+//
+// Usage:
+//   mines-solver-batch [--rows=N] [--cols=N] [--mines=N] [--games=N]
+//                      [--seed=N] [--solver=none|local|tiered] [--counters]
+//                      [--record=PATH] [--move-time-ms=N] [--density=P]
+//                      [--cascades]
+//
+// Each game starts by uncovering the center cell and then executes the
+// solver's actions until it makes no further progress. Game i uses the seed
+// (seed + i).
+//
+// With --move-time-ms, each call to the solver must return within N
+// milliseconds. Whatever actions it has found by then are executed; a call
+// that runs out of time without finding any ends the game as a timeout.
+//
+// With --record, every game is written to PATH in the format described in
+// mines/record/format.h. The rows, columns and mines must each fit in 32 bits.
+//
+// With --density, --mines is ignored and each cell is a mine with probability
+// P, decided by a hash rather than stored (see NewHashedGame). Such games
+// cannot be recorded.
+//
+// With --cascades, the cells uncovered by each action are sent as a single
+// cascade (see Game::SetCascadeEventsEnabled). Such games cannot be recorded.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "mines/game/game.h"
+#include "mines/game/instrumentation.h"
+#include "mines/record/writer.h"
+#include "mines/solver/solver.h"
+
+namespace mines {
+namespace {
+
+// Options controlling a batch run.
+struct BatchOptions {
+  std::size_t rows = 16;
+  std::size_t cols = 30;
+  std::size_t mines = 99;
+  std::size_t games = 1000;
+  unsigned seed = 0;
+  solver::Algorithm algorithm = solver::Algorithm::LOCAL;
+  bool counters = false;
+  const char* record_path = nullptr;
+  std::size_t move_time_ms = 0;
+
+  // If non-negative, games are created by NewHashedGame with this density.
+  double density = -1.0;
+
+  // If true, games send cascade events.
+  bool cascades = false;
+};
+
+// If arg has the form "<name>=<value>", returns a pointer to the value.
+// Otherwise returns nullptr.
+const char* MatchFlag(const char* arg, const char* name) {
+  const std::size_t len = std::strlen(name);
+  if (std::strncmp(arg, name, len) == 0 && arg[len] == '=') {
+    return arg + len + 1;
+  }
+  return nullptr;
+}
+
+// Parses the command line into options.
+//
+// Returns false if the command line is invalid.
+bool ParseOptions(int argc, char* argv[], BatchOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* value;
+    if ((value = MatchFlag(arg, "--rows")) != nullptr) {
+      options.rows = std::strtoul(value, nullptr, 10);
+    } else if ((value = MatchFlag(arg, "--cols")) != nullptr) {
+      options.cols = std::strtoul(value, nullptr, 10);
+    } else if ((value = MatchFlag(arg, "--mines")) != nullptr) {
+      options.mines = std::strtoul(value, nullptr, 10);
+    } else if ((value = MatchFlag(arg, "--games")) != nullptr) {
+      options.games = std::strtoul(value, nullptr, 10);
+    } else if ((value = MatchFlag(arg, "--seed")) != nullptr) {
+      options.seed = std::strtoul(value, nullptr, 10);
+    } else if ((value = MatchFlag(arg, "--solver")) != nullptr) {
+      if (std::strcmp(value, "none") == 0) {
+        options.algorithm = solver::Algorithm::NONE;
+      } else if (std::strcmp(value, "local") == 0) {
+        options.algorithm = solver::Algorithm::LOCAL;
+      } else if (std::strcmp(value, "tiered") == 0) {
+        options.algorithm = solver::Algorithm::TIERED;
+      } else {
+        return false;
+      }
+    } else if (std::strcmp(arg, "--counters") == 0) {
+      options.counters = true;
+    } else if ((value = MatchFlag(arg, "--record")) != nullptr) {
+      options.record_path = value;
+    } else if ((value = MatchFlag(arg, "--move-time-ms")) != nullptr) {
+      options.move_time_ms = std::strtoul(value, nullptr, 10);
+    } else if ((value = MatchFlag(arg, "--density")) != nullptr) {
+      options.density = std::strtod(value, nullptr);
+    } else if (std::strcmp(arg, "--cascades") == 0) {
+      options.cascades = true;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Runs all of the games and prints a summary.
+int RunBatch(const BatchOptions& options) {
+  std::size_t wins = 0;
+  std::size_t losses = 0;
+  std::size_t timeouts = 0;
+  GameCounters game_counters;
+  solver::SolverCounters solver_counters;
+
+  const bool hashed = options.density >= 0.0;
+  if (hashed && options.record_path != nullptr) {
+    std::fprintf(stderr, "games with --density cannot be recorded\n");
+    return 1;
+  }
+  if (options.cascades && options.record_path != nullptr) {
+    std::fprintf(stderr, "games with --cascades cannot be recorded\n");
+    return 1;
+  }
+  constexpr std::size_t kMaxRecorded =
+      std::numeric_limits<std::uint32_t>::max();
+  if (options.record_path != nullptr &&
+      (options.rows > kMaxRecorded || options.cols > kMaxRecorded ||
+       options.mines > kMaxRecorded)) {
+    std::fprintf(stderr,
+                 "games with more than %zu rows, columns or mines cannot be "
+                 "recorded\n",
+                 kMaxRecorded);
+    return 1;
+  }
+
+  std::unique_ptr<record::Writer> writer;
+  if (options.record_path != nullptr) {
+    writer = record::NewWriter(options.record_path);
+    if (writer == nullptr) {
+      std::fprintf(stderr, "unable to open %s\n", options.record_path);
+      return 1;
+    }
+  }
+
+  for (std::size_t i = 0; i < options.games; ++i) {
+    const unsigned seed = options.seed + i;
+    std::unique_ptr<Game> game =
+        hashed ? NewHashedGame(options.rows, options.cols, options.density,
+                               seed)
+               : NewGame(options.rows, options.cols, options.mines, seed);
+    if (game == nullptr) {
+      std::fprintf(stderr, "invalid game parameters\n");
+      return 1;
+    }
+    game->SetCascadeEventsEnabled(options.cascades);
+    std::unique_ptr<solver::Solver> solver =
+        solver::New(options.algorithm, *game);
+    if (solver == nullptr) {
+      std::fprintf(stderr, "the solver does not support a %zux%zu board\n",
+                   options.rows, options.cols);
+      return 1;
+    }
+    if (writer != nullptr) {
+      game->Subscribe(writer.get());
+    }
+
+    game->Execute(
+        Action{Action::Type::UNCOVER, options.rows / 2, options.cols / 2});
+    std::vector<Action> actions;
+    do {
+      solver::AnalyzeBudget budget;
+      if (options.move_time_ms != 0) {
+        budget = solver::AnalyzeBudget::For(
+            std::chrono::milliseconds(options.move_time_ms));
+      }
+      actions.clear();
+      if (solver->Analyze(budget, &actions) ==
+              solver::AnalyzeStatus::INCOMPLETE &&
+          actions.empty()) {
+        ++timeouts;
+        break;
+      }
+      game->Execute(actions);
+    } while (!actions.empty());
+
+    switch (game->GetState()) {
+      case Game::State::WIN:
+        ++wins;
+        break;
+      case Game::State::LOSS:
+        ++losses;
+        break;
+      default:
+        break;
+    }
+    game_counters.Merge(game->GetCounters());
+    solver_counters.Merge(solver->GetCounters());
+  }
+
+  if (writer != nullptr && !writer->Flush()) {
+    std::fprintf(stderr, "error writing %s\n", options.record_path);
+    return 1;
+  }
+
+  std::printf("games    %zu\n", options.games);
+  std::printf("wins     %zu\n", wins);
+  std::printf("losses   %zu\n", losses);
+  std::printf("stalled  %zu\n", options.games - wins - losses - timeouts);
+  if (options.move_time_ms != 0) {
+    std::printf("timeouts %zu\n", timeouts);
+  }
+
+  if (options.counters) {
+    if (!instrumentation::kEnabled) {
+      std::fprintf(stderr,
+                   "counters are only available when built with "
+                   "--enable-instrumentation\n");
+    }
+    PrintCounters(game_counters, stdout);
+    PrintCounters(solver_counters, stdout);
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace mines
+
+int main(int argc, char* argv[]) {
+  mines::BatchOptions options;
+  if (!mines::ParseOptions(argc, argv, options)) {
+    std::fprintf(stderr,
+                 "usage: %s [--rows=N] [--cols=N] [--mines=N] [--games=N] "
+                 "[--seed=N] [--solver=none|local|tiered] [--counters] "
+                 "[--record=PATH] [--move-time-ms=N] [--density=P] "
+                 "[--cascades]\n",
+                 argv[0]);
+    return 1;
+  }
+  return mines::RunBatch(options);
+}
@@ -0,0 +1,285 @@
+#include "mines/bench/benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "mines/compat/make_unique.h"
+#include "mines/game/instrumentation.h"
+
+namespace mines {
+namespace bench {
+
+namespace {
+
+// Options controlling how benchmarks are run and reported.
+struct RunOptions {
+  std::string filter;
+  double min_time_s = 0.5;
+  std::size_t repetitions = 5;
+  bool json = false;
+};
+
+// The measurements for a single benchmark run.
+struct Result {
+  std::string name;
+  std::size_t iterations;
+
+  // Per-iteration times across the repetitions.
+  double median_ns;
+  double min_ns;
+  double max_ns;
+
+  // Coefficient of variation of the per-iteration times.
+  double cv;
+
+  // Items processed per second at the median time, or zero if the benchmark
+  // does not report items.
+  double items_per_second;
+
+  // Bytes processed per second at the median time, or zero if the benchmark
+  // does not report bytes.
+  double bytes_per_second;
+};
+
+// The upper bound on iterations chosen during calibration.
+constexpr std::size_t kMaxIterations = 1000000000;
+
+// Calibration also stops once a run takes this many times the minimum time in
+// wall clock time. This bounds benchmarks that spend most of each iteration
+// with the timer paused.
+constexpr double kMaxWallTimeRatio = 10.0;
+
+// Returns the registry of benchmarks.
+std::vector<std::unique_ptr<Benchmark>>& GetRegistry() {
+  static std::vector<std::unique_ptr<Benchmark>> registry;
+  return registry;
+}
+
+// If arg has the form "<name>=<value>", returns a pointer to the value.
+// Otherwise returns nullptr.
+const char* MatchFlag(const char* arg, const char* name) {
+  const std::size_t len = std::strlen(name);
+  if (std::strncmp(arg, name, len) == 0 && arg[len] == '=') {
+    return arg + len + 1;
+  }
+  return nullptr;
+}
+
+// Parses the command line into options.
+//
+// Returns false if the command line is invalid.
+bool ParseOptions(int argc, char* argv[], RunOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* value;
+    if ((value = MatchFlag(arg, "--filter")) != nullptr) {
+      options.filter = value;
+    } else if ((value = MatchFlag(arg, "--min_time")) != nullptr) {
+      options.min_time_s = std::strtod(value, nullptr);
+    } else if ((value = MatchFlag(arg, "--repetitions")) != nullptr) {
+      options.repetitions = std::max(1ul, std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(arg, "--json") == 0) {
+      options.json = true;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Runs the benchmark function once for the given number of iterations.
+//
+// Returns the elapsed time per iteration in nanoseconds. The number of items
+// and bytes per iteration reported by the benchmark are stored in items and
+// bytes.
+double RunIterations(Function fn, std::int64_t arg, std::size_t iterations,
+                     double& items, double& bytes) {
+  State state(iterations, arg);
+  fn(state);
+  items = static_cast<double>(state.GetItemsProcessed()) / iterations;
+  bytes = static_cast<double>(state.GetBytesProcessed()) / iterations;
+  return state.GetElapsedNs() / iterations;
+}
+
+// Chooses a number of iterations such that a single run takes at least the
+// minimum time. No fewer than min_iterations are chosen.
+std::size_t Calibrate(Function fn, std::int64_t arg, double min_time_ns,
+                      std::size_t min_iterations) {
+  std::size_t iterations = 1;
+  for (;;) {
+    double items;
+    double bytes;
+    const State::Clock::time_point start = State::Clock::now();
+    const double elapsed_ns =
+        RunIterations(fn, arg, iterations, items, bytes) * iterations;
+    const double wall_ns = std::chrono::duration<double, std::nano>(
+                               State::Clock::now() - start)
+                               .count();
+    if (elapsed_ns >= min_time_ns || iterations >= kMaxIterations ||
+        wall_ns >= kMaxWallTimeRatio * min_time_ns) {
+      return std::max(iterations, min_iterations);
+    }
+
+    // Overshoot slightly so the next attempt is likely to be the last.
+    double multiplier = 1.4 * min_time_ns / std::max(elapsed_ns, 1.0);
+    multiplier = std::min(std::max(multiplier, 2.0), 100.0);
+    iterations = std::min(
+        kMaxIterations, static_cast<std::size_t>(iterations * multiplier));
+  }
+}
+
+// Runs one benchmark with one argument and summarizes the repetitions.
+Result Run(const std::string& name, const Benchmark& benchmark,
+           std::int64_t arg, const RunOptions& options) {
+  const Function fn = benchmark.GetFunction();
+  Result result;
+  result.name = name;
+  result.iterations = Calibrate(fn, arg, options.min_time_s * 1e9,
+                                benchmark.GetMinIterations());
+
+  // The first run at the chosen number of iterations is not measured. It
+  // brings the caches, the allocator and the clock frequency to the state
+  // the measured repetitions see.
+  double items = 0.0;
+  double bytes = 0.0;
+  RunIterations(fn, arg, result.iterations, items, bytes);
+
+  std::vector<double> times;
+  for (std::size_t i = 0; i < options.repetitions; ++i) {
+    times.push_back(RunIterations(fn, arg, result.iterations, items, bytes));
+  }
+  std::sort(times.begin(), times.end());
+
+  const std::size_t n = times.size();
+  result.median_ns =
+      n % 2 == 1 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+  result.min_ns = times.front();
+  result.max_ns = times.back();
+
+  double mean = 0.0;
+  for (double t : times) {
+    mean += t;
+  }
+  mean /= n;
+  double variance = 0.0;
+  for (double t : times) {
+    variance += (t - mean) * (t - mean);
+  }
+  variance /= n;
+  result.cv = mean > 0.0 ? std::sqrt(variance) / mean : 0.0;
+
+  result.items_per_second =
+      result.median_ns > 0.0 ? items * 1e9 / result.median_ns : 0.0;
+  result.bytes_per_second =
+      result.median_ns > 0.0 ? bytes * 1e9 / result.median_ns : 0.0;
+  return result;
+}
+
+// Writes the header of the table output.
+void PrintTableHeader() {
+  std::printf("%-40s %15s %8s %12s %14s %14s\n", "Benchmark",
+              "Time/iter (ns)", "CV", "Iterations", "Items/s", "Bytes/s");
+}
+
+// Writes a single result as a table row.
+void PrintTableRow(const Result& result) {
+  std::printf("%-40s %15.1f %7.2f%% %12zu", result.name.c_str(),
+              result.median_ns, 100.0 * result.cv, result.iterations);
+  if (result.items_per_second > 0.0) {
+    std::printf(" %14.4g", result.items_per_second);
+  } else if (result.bytes_per_second > 0.0) {
+    std::printf(" %14s", "");
+  }
+  if (result.bytes_per_second > 0.0) {
+    std::printf(" %14.4g", result.bytes_per_second);
+  }
+  std::printf("\n");
+  std::fflush(stdout);
+}
+
+// Writes all of the results as JSON.
+void PrintJson(const std::vector<Result>& results,
+               const RunOptions& options) {
+  std::printf("{\n");
+  std::printf("  \"context\": {\n");
+  std::printf("    \"min_time_s\": %g,\n", options.min_time_s);
+  std::printf("    \"repetitions\": %zu,\n", options.repetitions);
+  std::printf("    \"instrumentation\": %s\n",
+              instrumentation::kEnabled ? "true" : "false");
+  std::printf("  },\n");
+  std::printf("  \"benchmarks\": [");
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const Result& result = results[i];
+    std::printf(i == 0 ? "\n" : ",\n");
+    std::printf("    {\n");
+    std::printf("      \"name\": \"%s\",\n", result.name.c_str());
+    std::printf("      \"iterations\": %zu,\n", result.iterations);
+    std::printf("      \"median_ns\": %.1f,\n", result.median_ns);
+    std::printf("      \"min_ns\": %.1f,\n", result.min_ns);
+    std::printf("      \"max_ns\": %.1f,\n", result.max_ns);
+    std::printf("      \"cv\": %.4f,\n", result.cv);
+    std::printf("      \"items_per_second\": %.1f,\n", result.items_per_second);
+    std::printf("      \"bytes_per_second\": %.1f\n", result.bytes_per_second);
+    std::printf("    }");
+  }
+  std::printf("\n  ]\n}\n");
+}
+
+}  // namespace
+
+Benchmark* Register(const char* name, Function fn) {
+  GetRegistry().push_back(MakeUnique<Benchmark>(name, fn));
+  return GetRegistry().back().get();
+}
+
+int RunBenchmarks(int argc, char* argv[]) {
+  RunOptions options;
+  if (!ParseOptions(argc, argv, options)) {
+    std::fprintf(stderr,
+                 "usage: %s [--filter=<substring>] [--min_time=<seconds>] "
+                 "[--repetitions=<n>] [--json]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  if (!options.json) {
+    PrintTableHeader();
+  }
+
+  std::vector<Result> results;
+  for (const std::unique_ptr<Benchmark>& benchmark : GetRegistry()) {
+    // Benchmarks without arguments are run once with an argument of zero.
+    std::vector<std::int64_t> args = benchmark->GetArgs();
+    const bool has_args = !args.empty();
+    if (!has_args) {
+      args.push_back(0);
+    }
+
+    for (std::int64_t arg : args) {
+      std::string name = benchmark->GetName();
+      if (has_args) {
+        name += "/" + std::to_string(arg);
+      }
+      if (name.find(options.filter) == std::string::npos) {
+        continue;
+      }
+
+      results.push_back(Run(name, *benchmark, arg, options));
+      if (!options.json) {
+        PrintTableRow(results.back());
+      }
+    }
+  }
+
+  if (options.json) {
+    PrintJson(results, options);
+  }
+  return 0;
+}
+
+}  // namespace bench
+}  // namespace mines
@@ -0,0 +1,173 @@
+#ifndef MINES_BENCH_BENCHMARK_H_
+#define MINES_BENCH_BENCHMARK_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mines {
+namespace bench {
+
+// The state passed to a benchmark function.
+//
+// A benchmark function runs its timed body in a loop:
+//   void BM_Something(State& state) {
+//     // Untimed setup.
+//     while (state.KeepRunning()) {
+//       // Timed body.
+//     }
+//   }
+class State {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  State(std::size_t iterations, std::int64_t arg)
+      : max_iterations_(iterations), arg_(arg) {}
+
+  State(const State&) = delete;
+  State& operator=(const State&) = delete;
+
+  // Returns true while the timed body should be run again.
+  //
+  // Timing starts on the first call and stops on the call that returns false.
+  bool KeepRunning() {
+    if (iterations_ < max_iterations_) {
+      if (iterations_++ == 0) {
+        ResumeTiming();
+      }
+      return true;
+    }
+    PauseTiming();
+    return false;
+  }
+
+  // Stops the timer, e.g. to exclude per-iteration setup.
+  void PauseTiming() {
+    if (timing_) {
+      elapsed_ += Clock::now() - start_;
+      timing_ = false;
+    }
+  }
+
+  // Restarts the timer after a call to PauseTiming.
+  void ResumeTiming() {
+    if (!timing_) {
+      start_ = Clock::now();
+      timing_ = true;
+    }
+  }
+
+  // Returns the argument the benchmark was registered with.
+  std::int64_t Arg() const { return arg_; }
+
+  // Returns the number of iterations the timed body will be run.
+  std::size_t MaxIterations() const { return max_iterations_; }
+
+  // Sets the total number of items processed over all iterations. This is
+  // reported as a rate.
+  void SetItemsProcessed(std::size_t items) { items_ = items; }
+
+  // Returns the number of items processed over all iterations.
+  std::size_t GetItemsProcessed() const { return items_; }
+
+  // Sets the total number of bytes processed over all iterations. This is
+  // reported as a rate.
+  void SetBytesProcessed(std::size_t bytes) { bytes_ = bytes; }
+
+  // Returns the number of bytes processed over all iterations.
+  std::size_t GetBytesProcessed() const { return bytes_; }
+
+  // Returns the timed duration in nanoseconds.
+  double GetElapsedNs() const {
+    return std::chrono::duration<double, std::nano>(elapsed_).count();
+  }
+
+ private:
+  const std::size_t max_iterations_;
+  const std::int64_t arg_;
+  std::size_t iterations_ = 0;
+  std::size_t items_ = 0;
+  std::size_t bytes_ = 0;
+
+  bool timing_ = false;
+  Clock::time_point start_;
+  Clock::duration elapsed_ = Clock::duration::zero();
+};
+
+// A benchmark function.
+using Function = void (*)(State&);
+
+// A registered benchmark.
+class Benchmark {
+ public:
+  Benchmark(const char* name, Function fn) : name_(name), fn_(fn) {}
+
+  // Adds an argument. The benchmark is run once for each argument, and each
+  // run is reported as "<name>/<arg>". Benchmarks without arguments are run
+  // once.
+  Benchmark* Arg(std::int64_t arg) {
+    args_.push_back(arg);
+    return this;
+  }
+
+  // Sets the fewest iterations of each repetition, overriding the default. A
+  // benchmark whose iterations are short but whose untimed setup is long
+  // would otherwise be cut off after a few iterations by the wall clock limit.
+  Benchmark* MinIterations(std::size_t iterations) {
+    min_iterations_ = iterations;
+    return this;
+  }
+
+  const std::string& GetName() const { return name_; }
+  Function GetFunction() const { return fn_; }
+  const std::vector<std::int64_t>& GetArgs() const { return args_; }
+  std::size_t GetMinIterations() const { return min_iterations_; }
+
+ private:
+  // The default for MinIterations.
+  static constexpr std::size_t kDefaultMinIterations = 4;
+
+  const std::string name_;
+  const Function fn_;
+  std::vector<std::int64_t> args_;
+  std::size_t min_iterations_ = kDefaultMinIterations;
+};
+
+// Registers a benchmark. Prefer the MINES_BENCHMARK macro.
+Benchmark* Register(const char* name, Function fn);
+
+// Runs all registered benchmarks and reports the results.
+//
+// Recognized flags:
+//   --filter=<substring>  Only run benchmarks whose name contains substring.
+//   --min_time=<seconds>  Minimum timed duration of each repetition.
+//   --repetitions=<n>     Number of repetitions; the median is reported.
+//
+// Each benchmark is run once, unmeasured, before its repetitions to warm up.
+//   --json                Write results as JSON rather than a table.
+//
+// Returns a process exit code.
+int RunBenchmarks(int argc, char* argv[]);
+
+// Prevents the compiler from optimizing away the computation of value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // namespace bench
+}  // namespace mines
+
+#define MINES_BENCHMARK_CONCAT(a, b) MINES_BENCHMARK_CONCAT_(a, b)
+#define MINES_BENCHMARK_CONCAT_(a, b) a##b
+
+// Registers a benchmark function. Arguments may be chained:
+//   MINES_BENCHMARK(BM_Something)->Arg(10)->Arg(100);
+#define MINES_BENCHMARK(fn)                         \
+  static ::mines::bench::Benchmark* const           \
+      MINES_BENCHMARK_CONCAT(benchmark_, __LINE__) = \
+          ::mines::bench::Register(#fn, fn)
+
+#endif  // MINES_BENCH_BENCHMARK_H_
@@ -0,0 +1,5 @@
+#include "mines/bench/benchmark.h"
+
+int main(int argc, char* argv[]) {
+  return mines::bench::RunBenchmarks(argc, argv);
+}
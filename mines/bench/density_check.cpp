@@ -0,0 +1,186 @@
+// Checks that the mines placed by NewHashedGame match the statistics of those
+// placed by NewGame with the expected number of mines.
+//
+// Usage:
+//   density-check [games]
+//
+// For each density, games are played in both modes until they are lost, and
+// the mines identified by the loss are measured. The exit status is non-zero
+// if the density of the hashed games, or their probability of two adjacent
+// mines, is more than four standard errors from that of independent cells.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "mines/game/game.h"
+
+namespace mines {
+namespace bench {
+
+namespace {
+
+// Board dimensions. The board is stored densely, so a loss identifies every
+// mine.
+constexpr std::size_t kRows = 500;
+constexpr std::size_t kCols = 500;
+
+// The number of standard errors allowed before a check fails.
+constexpr double kMaxError = 4.0;
+
+// Records the mines identified when a game is lost.
+class MineCollector : public EventSubscriber {
+ public:
+  MineCollector() : mines_(kRows * kCols, false) {}
+
+  void NotifyEvent(const Event& event) final {
+    if (event.type == Event::Type::IDENTIFY_MINE) {
+      mines_[event.row * kCols + event.col] = true;
+    }
+  }
+
+  bool IsMine(std::size_t row, std::size_t col) const {
+    return mines_[row * kCols + col];
+  }
+
+ private:
+  std::vector<bool> mines_;
+};
+
+// Measurements of the mines across a number of games.
+struct Stats {
+  std::size_t cells = 0;
+  std::size_t mines = 0;
+
+  // Pairs of horizontally or vertically adjacent cells, and those pairs in
+  // which both cells are mines.
+  std::size_t pairs = 0;
+  std::size_t mine_pairs = 0;
+
+  // The number of cells without a mine with each number of adjacent mines.
+  std::size_t adjacent[9] = {};
+};
+
+// Loses the game by uncovering cells in row major order, then adds its mines
+// to stats. Returns false if the game could not be lost.
+bool Measure(Game* game, Stats* stats) {
+  MineCollector collector;
+  game->Subscribe(&collector);
+  game->Execute(Action{Action::Type::UNCOVER, kRows / 2, kCols / 2});
+  for (std::size_t index = 0;
+       index < kRows * kCols && game->GetState() == Game::State::PLAYING;
+       ++index) {
+    game->Execute(Action{Action::Type::UNCOVER, index / kCols, index % kCols});
+  }
+  if (game->GetState() != Game::State::LOSS) {
+    return false;
+  }
+
+  for (std::size_t row = 0; row < kRows; ++row) {
+    for (std::size_t col = 0; col < kCols; ++col) {
+      const bool mine = collector.IsMine(row, col);
+      ++stats->cells;
+      stats->mines += mine ? 1 : 0;
+      if (col + 1 < kCols) {
+        ++stats->pairs;
+        stats->mine_pairs += mine && collector.IsMine(row, col + 1) ? 1 : 0;
+      }
+      if (row + 1 < kRows) {
+        ++stats->pairs;
+        stats->mine_pairs += mine && collector.IsMine(row + 1, col) ? 1 : 0;
+      }
+      if (mine) {
+        continue;
+      }
+      std::size_t adjacent = 0;
+      for (std::size_t r = row == 0 ? 0 : row - 1;
+           r <= std::min(row + 1, kRows - 1); ++r) {
+        for (std::size_t c = col == 0 ? 0 : col - 1;
+             c <= std::min(col + 1, kCols - 1); ++c) {
+          adjacent += collector.IsMine(r, c) ? 1 : 0;
+        }
+      }
+      ++stats->adjacent[adjacent];
+    }
+  }
+  return true;
+}
+
+// Returns the number of standard errors between the frequency count / total
+// and the probability p.
+double Error(std::size_t count, std::size_t total, double p) {
+  const double frequency = static_cast<double>(count) / total;
+  return (frequency - p) / std::sqrt(p * (1.0 - p) / total);
+}
+
+// Compares hashed and exact games at the given density. Returns false if the
+// hashed games fail a check.
+bool Check(int games, double density) {
+  const std::size_t mines = static_cast<std::size_t>(
+      std::llround(density * static_cast<double>(kRows * kCols)));
+  Stats hashed;
+  Stats exact;
+  for (int seed = 0; seed < games; ++seed) {
+    std::unique_ptr<Game> game = NewHashedGame(kRows, kCols, density, seed);
+    if (game == nullptr || !Measure(game.get(), &hashed)) {
+      std::fprintf(stderr, "hashed game %d could not be measured\n", seed);
+      return false;
+    }
+    game = NewGame(kRows, kCols, mines, seed);
+    if (game == nullptr || !Measure(game.get(), &exact)) {
+      std::fprintf(stderr, "exact game %d could not be measured\n", seed);
+      return false;
+    }
+  }
+
+  const double density_error = Error(hashed.mines, hashed.cells, density);
+  const double pair_error =
+      Error(hashed.mine_pairs, hashed.pairs, density * density);
+  std::printf("density                %.3f\n", density);
+  std::printf("games                  %d\n", games);
+  std::printf("hashed_density         %.5f (%+.2f se)\n",
+              static_cast<double>(hashed.mines) / hashed.cells, density_error);
+  std::printf("exact_density          %.5f\n",
+              static_cast<double>(exact.mines) / exact.cells);
+  std::printf("hashed_pair_prob       %.5f (%+.2f se)\n",
+              static_cast<double>(hashed.mine_pairs) / hashed.pairs,
+              pair_error);
+  std::printf("exact_pair_prob        %.5f\n",
+              static_cast<double>(exact.mine_pairs) / exact.pairs);
+
+  // The distribution of the numbers shown on the cells without a mine.
+  double max_difference = 0.0;
+  for (std::size_t i = 0; i < 9; ++i) {
+    const double h = static_cast<double>(hashed.adjacent[i]) /
+                     (hashed.cells - hashed.mines);
+    const double e =
+        static_cast<double>(exact.adjacent[i]) / (exact.cells - exact.mines);
+    std::printf("adjacent_%zu             %.5f %.5f\n", i, h, e);
+    max_difference = std::max(max_difference, std::fabs(h - e));
+  }
+  std::printf("adjacent_max_diff      %.5f\n", max_difference);
+
+  return std::fabs(density_error) <= kMaxError &&
+         std::fabs(pair_error) <= kMaxError;
+}
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace mines
+
+int main(int argc, char* argv[]) {
+  const int games = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 20;
+  std::printf("board                  %zux%zu\n", mines::bench::kRows,
+              mines::bench::kCols);
+  bool ok = true;
+  for (double density : {0.1, 0.2, 0.4}) {
+    ok = mines::bench::Check(games, density) && ok;
+  }
+  std::printf("result                 %s\n", ok ? "pass" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+// Benchmarks for the game engine.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mines/bench/benchmark.h"
+#include "mines/game/game.h"
+#include "mines/game/grid.h"
+#include "mines/game/tiled_grid.h"
+
+namespace mines {
+namespace bench {
+
+namespace {
+
+// A cell of roughly the same size as the one used by the game engine.
+struct GameSizedCell {
+  bool is_mine = false;
+  std::uint8_t state = 0;
+};
+
+// Constructs square grids with Arg() rows and columns.
+void BM_GridConstruction(State& state) {
+  const std::size_t size = state.Arg();
+  while (state.KeepRunning()) {
+    Grid<GameSizedCell> grid(size, size);
+    DoNotOptimize(grid(size - 1, size - 1));
+  }
+  state.SetItemsProcessed(state.MaxIterations() * size * size);
+}
+MINES_BENCHMARK(BM_GridConstruction)->Arg(16)->Arg(100)->Arg(1000);
+
+// Counts the neighbors of every cell of a 1000x1000 grid of type CellGrid.
+template <class CellGrid>
+void CountAllAdjacent(State& state) {
+  constexpr std::size_t kSize = 1000;
+  CellGrid grid(kSize, kSize);
+  for (std::size_t row = 0; row < kSize; ++row) {
+    for (std::size_t col = 0; col < kSize; ++col) {
+      grid(row, col).is_mine = (row * 7 + col * 13) % 5 == 0;
+    }
+  }
+
+  const CellGrid& cgrid = grid;
+  while (state.KeepRunning()) {
+    std::size_t total = 0;
+    for (std::size_t row = 0; row < kSize; ++row) {
+      for (std::size_t col = 0; col < kSize; ++col) {
+        total += cgrid.ForEachAdjacent(
+            row, col, [&cgrid](std::size_t row, std::size_t col) {
+              return cgrid(row, col).is_mine;
+            });
+      }
+    }
+    DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.MaxIterations() * kSize * kSize);
+}
+
+void BM_ForEachAdjacent(State& state) {
+  CountAllAdjacent<Grid<GameSizedCell>>(state);
+}
+MINES_BENCHMARK(BM_ForEachAdjacent);
+
+void BM_TiledForEachAdjacent(State& state) {
+  CountAllAdjacent<TiledGrid<GameSizedCell>>(state);
+}
+MINES_BENCHMARK(BM_TiledForEachAdjacent);
+
+// Creates games on a square board with Arg() rows and columns and 1000 mines.
+// Boards over kMaxDenseGridCells are stored sparsely, so the largest board
+// costs about the same as the smallest.
+void BM_NewSparseGame(State& state) {
+  const std::size_t size = state.Arg();
+  unsigned seed = 0;
+  while (state.KeepRunning()) {
+    std::unique_ptr<Game> game = NewGame(size, size, 1000, seed++);
+    DoNotOptimize(game.get());
+  }
+  state.SetItemsProcessed(state.MaxIterations());
+}
+MINES_BENCHMARK(BM_NewSparseGame)->Arg(1000)->Arg(100000);
+
+// Creates 1000x1000 games with a mine density of Arg() percent.
+void BM_NewGame(State& state) {
+  constexpr std::size_t kSize = 1000;
+  const std::size_t mines = kSize * kSize * state.Arg() / 100;
+  unsigned seed = 0;
+  while (state.KeepRunning()) {
+    std::unique_ptr<Game> game = NewGame(kSize, kSize, mines, seed++);
+    DoNotOptimize(game.get());
+  }
+  state.SetItemsProcessed(state.MaxIterations() * kSize * kSize);
+}
+MINES_BENCHMARK(BM_NewGame)->Arg(1)->Arg(10)->Arg(20)->Arg(50);
+
+// Creates 1000x1000 games with mines placed by a hash at a density of Arg()
+// percent. The mines are neither stored nor counted, so the cost is dominated
+// by allocating the grid.
+void BM_NewHashedGame(State& state) {
+  constexpr std::size_t kSize = 1000;
+  const double density = state.Arg() / 100.0;
+  unsigned seed = 0;
+  while (state.KeepRunning()) {
+    std::unique_ptr<Game> game = NewHashedGame(kSize, kSize, density, seed++);
+    DoNotOptimize(game.get());
+  }
+  state.SetItemsProcessed(state.MaxIterations() * kSize * kSize);
+}
+MINES_BENCHMARK(BM_NewHashedGame)->Arg(1)->Arg(10)->Arg(20)->Arg(50);
+
+// Counts the cells uncovered in a game.
+class UncoverCounter : public EventSubscriber {
+ public:
+  void NotifyEvent(const Event& event) final {
+    if (event.type == Event::Type::UNCOVER) {
+      ++count_;
+    }
+  }
+
+  void NotifyCascade(const Cascade& cascade) final {
+    count_ += cascade.GetSize();
+  }
+
+  std::size_t GetCount() const { return count_; }
+
+ private:
+  std::size_t count_ = 0;
+};
+
+// Uncovers the center of a 1000x1000 board with 5% mines, using Arg() as the
+// seed. The seeds are chosen so that the first click opens most of the board.
+void UncoverCascade(State& state, bool cascade_events) {
+  constexpr std::size_t kSize = 1000;
+  constexpr std::size_t kMines = kSize * kSize / 20;
+  const unsigned seed = state.Arg();
+
+  UncoverCounter counter;
+  std::unique_ptr<Game> game;
+  while (state.KeepRunning()) {
+    // Creating the game (and destroying the previous one) is not timed.
+    state.PauseTiming();
+    game = NewGame(kSize, kSize, kMines, seed);
+    game->SetCascadeEventsEnabled(cascade_events);
+    game->Subscribe(&counter);
+    state.ResumeTiming();
+
+    game->Execute(Action{Action::Type::UNCOVER, kSize / 2, kSize / 2});
+  }
+  state.SetItemsProcessed(counter.GetCount());
+}
+
+// Sends the opening as an UNCOVER event per cell.
+void BM_UncoverCascade(State& state) { UncoverCascade(state, false); }
+MINES_BENCHMARK(BM_UncoverCascade)->Arg(2)->Arg(5)->Arg(7)->MinIterations(16);
+
+// Sends the opening as a single cascade.
+void BM_UncoverCascadeEvents(State& state) { UncoverCascade(state, true); }
+MINES_BENCHMARK(BM_UncoverCascadeEvents)
+    ->Arg(2)
+    ->Arg(5)
+    ->Arg(7)
+    ->MinIterations(16);
+
+// Records the numbered cells uncovered in a game.
+class NumberRecorder : public EventSubscriber {
+ public:
+  void NotifyEvent(const Event& event) final {
+    if (event.type == Event::Type::UNCOVER && event.adjacent_mines > 0) {
+      cells_.push_back(Action{Action::Type::CHORD, event.row, event.col});
+    }
+  }
+
+  const std::vector<Action>& GetChords() const { return cells_; }
+
+ private:
+  std::vector<Action> cells_;
+};
+
+// Chords every numbered cell opened by the first click of a 1000x1000 board
+// with 5% mines. No cells are flagged, so each chord is validated and
+// rejected, as most chords are while a solver is working.
+void BM_RejectChord(State& state) {
+  constexpr std::size_t kSize = 1000;
+  std::unique_ptr<Game> game = NewGame(kSize, kSize, kSize * kSize / 20, 5);
+  NumberRecorder recorder;
+  game->Subscribe(&recorder);
+  game->Execute(Action{Action::Type::UNCOVER, kSize / 2, kSize / 2});
+  const std::vector<Action> chords = recorder.GetChords();
+
+  while (state.KeepRunning()) {
+    for (const Action& chord : chords) {
+      game->Execute(chord);
+    }
+  }
+  state.SetItemsProcessed(state.MaxIterations() * chords.size());
+}
+MINES_BENCHMARK(BM_RejectChord);
+
+// Records the location of the mine that lost a game.
+class LossFinder : public EventSubscriber {
+ public:
+  void NotifyEvent(const Event& event) final {
+    if (event.type == Event::Type::LOSS) {
+      row_ = event.row;
+      col_ = event.col;
+    }
+  }
+
+  std::size_t GetRow() const { return row_; }
+  std::size_t GetCol() const { return col_; }
+
+ private:
+  std::size_t row_ = 0;
+  std::size_t col_ = 0;
+};
+
+// Loses a 1000x1000 game with Arg() percent mines, then undoes the loss. The
+// loss generates an event for every mine.
+void BM_LoseGame(State& state) {
+  constexpr std::size_t kSize = 1000;
+  const std::size_t mines = kSize * kSize * state.Arg() / 100;
+  std::unique_ptr<Game> game = NewGame(kSize, kSize, mines, 1);
+  LossFinder finder;
+  game->Subscribe(&finder);
+  game->SetUndoEnabled(true);
+
+  // Uncover cells until one is a mine.
+  for (std::size_t i = 0; !game->IsGameOver(); ++i) {
+    game->Execute(Action{Action::Type::UNCOVER, i / kSize, i % kSize});
+  }
+  game->Undo();
+
+  const Action lose{Action::Type::UNCOVER, finder.GetRow(), finder.GetCol()};
+  while (state.KeepRunning()) {
+    game->Execute(lose);
+    game->Undo();
+  }
+  state.SetItemsProcessed(state.MaxIterations());
+}
+MINES_BENCHMARK(BM_LoseGame)->Arg(1)->Arg(10)->Arg(20);
+
+// Returns a game with Arg() rows and columns and 15% mines, after its center
+// has been uncovered.
+std::unique_ptr<Game> NewBranchingGame(State& state) {
+  const std::size_t size = state.Arg();
+  std::unique_ptr<Game> game = NewGame(size, size, size * size * 15 / 100, 1);
+  game->Execute(Action{Action::Type::UNCOVER, size / 2, size / 2});
+  return game;
+}
+
+// Saves the state of a game into an existing snapshot.
+void BM_GameSnapshot(State& state) {
+  std::unique_ptr<Game> game = NewBranchingGame(state);
+  std::unique_ptr<GameSnapshot> snapshot = game->Snapshot();
+  while (state.KeepRunning()) {
+    game->Snapshot(snapshot.get());
+  }
+  state.SetItemsProcessed(state.MaxIterations());
+}
+MINES_BENCHMARK(BM_GameSnapshot)->Arg(16)->Arg(100)->Arg(1000);
+
+// Branches a game: tries an action from a saved position, then restores it.
+void BM_GameBranch(State& state) {
+  std::unique_ptr<Game> game = NewBranchingGame(state);
+  std::unique_ptr<GameSnapshot> snapshot = game->Snapshot();
+  std::size_t col = 0;
+  while (state.KeepRunning()) {
+    game->Execute(Action{Action::Type::FLAG, 0, col});
+    game->Restore(*snapshot);
+    col = (col + 1) % game->GetCols();
+  }
+  state.SetItemsProcessed(state.MaxIterations());
+}
+MINES_BENCHMARK(BM_GameBranch)->Arg(16)->Arg(100)->Arg(1000);
+
+// Branches a game as BM_GameBranch does, using the undo journal instead of a
+// snapshot.
+void BM_GameUndo(State& state) {
+  std::unique_ptr<Game> game = NewBranchingGame(state);
+  game->SetUndoEnabled(true);
+  std::size_t col = 0;
+  while (state.KeepRunning()) {
+    game->Execute(Action{Action::Type::FLAG, 0, col});
+    game->Undo();
+    col = (col + 1) % game->GetCols();
+  }
+  state.SetItemsProcessed(state.MaxIterations());
+}
+MINES_BENCHMARK(BM_GameUndo)->Arg(16)->Arg(100)->Arg(1000);
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace mines
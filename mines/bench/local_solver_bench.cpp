@@ -0,0 +1,155 @@
+// Benchmarks the memory footprint and solve time of the local solver on very
+// large boards.
+//
+// Usage:
+//   local-solver-bench [games]
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "mines/game/game.h"
+#include "mines/game/instrumentation.h"
+#include "mines/solver/local.h"
+#include "mines/solver/solver.h"
+
+namespace mines {
+namespace bench {
+
+namespace {
+
+// Board dimensions. Ten percent density gives large openings for the solver to
+// work through.
+constexpr std::size_t kRows = 1000;
+constexpr std::size_t kCols = 1000;
+constexpr std::size_t kMines = kRows * kCols / 10;
+
+// The number of solvers subscribed to a single game when measuring memory.
+constexpr std::size_t kSolversPerGame = 16;
+
+using Clock = std::chrono::steady_clock;
+
+// Returns the elapsed time since start in milliseconds.
+double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// Returns the peak resident set size of the process in kilobytes.
+long PeakRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Measures the memory consumed by many solvers subscribed to the same game.
+//
+// The solvers are added to solvers, which keeps them alive so that the peak
+// resident set size also measures any later call.
+void BenchMemory(const char* label, const solver::local::Options& options,
+                 Game* game,
+                 std::vector<std::unique_ptr<solver::Solver>>* solvers) {
+  const long rss_before = PeakRssKb();
+  const Clock::time_point start = Clock::now();
+  for (std::size_t i = 0; i < kSolversPerGame; ++i) {
+    solvers->push_back(solver::local::New(*game, options));
+    game->Subscribe(solvers->back().get());
+  }
+  const double construct_ms = ElapsedMs(start);
+  const long rss_after = PeakRssKb();
+
+  std::printf("view                   %s\n", label);
+  std::printf("solvers_per_game       %zu\n", kSolversPerGame);
+  std::printf("construct_ms_per_solver %.2f\n", construct_ms / kSolversPerGame);
+  std::printf("rss_kb_per_solver      %ld\n",
+              (rss_after - rss_before) / static_cast<long>(kSolversPerGame));
+}
+
+// Measures the time and the number of Analyze calls to play games to
+// completion with the given solver options. The number of cells analyzed is
+// also reported when the program is built with instrumentation enabled.
+void BenchSolve(int games, const char* label,
+                const solver::local::Options& options) {
+  double total_ms = 0.0;
+  std::size_t total_actions = 0;
+  std::size_t total_analyze_calls = 0;
+  solver::SolverCounters counters;
+  for (int seed = 0; seed < games; ++seed) {
+    std::unique_ptr<Game> game = NewGame(kRows, kCols, kMines, seed);
+    std::unique_ptr<solver::Solver> solver =
+        solver::local::New(*game, options);
+    game->Subscribe(solver.get());
+
+    const Clock::time_point start = Clock::now();
+    game->Execute(Action{Action::Type::UNCOVER, kRows / 2, kCols / 2});
+    std::vector<Action> actions;
+    do {
+      actions = solver->Analyze();
+      game->Execute(actions);
+      total_actions += actions.size();
+      ++total_analyze_calls;
+    } while (!actions.empty());
+    total_ms += ElapsedMs(start);
+    counters.Merge(solver->GetCounters());
+  }
+
+  std::printf("mode                   %s\n", label);
+  std::printf("games                  %d\n", games);
+  std::printf("solve_ms_per_game      %.2f\n", total_ms / games);
+  std::printf("actions_per_game       %zu\n", total_actions / games);
+  std::printf("analyze_calls_per_game %zu\n", total_analyze_calls / games);
+  std::printf("redundant_per_game     %zu\n",
+              counters.redundant_analyses_avoided / games);
+  if (instrumentation::kEnabled) {
+    std::printf("analyzed_per_game      %zu\n",
+                counters.cells_analyzed / games);
+  }
+}
+
+// Measures the memory of solvers with their own views and with the game's.
+void BenchMemoryModes() {
+  std::unique_ptr<Game> game = NewGame(kRows, kCols, kMines, 0);
+  std::vector<std::unique_ptr<solver::Solver>> solvers;
+
+  solver::local::Options options;
+  BenchMemory("own", options, game.get(), &solvers);
+
+  options.shared_view = true;
+  BenchMemory("shared", options, game.get(), &solvers);
+}
+
+// Measures each of the solver modes.
+void BenchSolveModes(int games) {
+  solver::local::Options options;
+  BenchSolve(games, "single", options);
+
+  options.prioritize = true;
+  BenchSolve(games, "single-priority", options);
+
+  options.prioritize = false;
+  options.fixpoint = true;
+  BenchSolve(games, "fixpoint", options);
+
+  options.shared_view = true;
+  BenchSolve(games, "fixpoint-shared", options);
+}
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace mines
+
+int main(int argc, char* argv[]) {
+  const int games = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 5;
+  std::printf("board                  %zux%zu, %zu mines\n", mines::bench::kRows,
+              mines::bench::kCols, mines::bench::kMines);
+  mines::bench::BenchMemoryModes();
+  mines::bench::BenchSolveModes(games);
+  return 0;
+}
@@ -0,0 +1,157 @@
+// Benchmarks for drawing the mine field.
+//
+// These draw onto an offscreen Cairo image surface, so no display is needed.
+
+#include <algorithm>
+#include <cstddef>
+
+#include <cairomm/context.h>
+#include <cairomm/refptr.h>
+#include <cairomm/surface.h>
+#include <gtkmm/main.h>
+
+#include "mines/bench/benchmark.h"
+#include "mines/game/game.h"
+#include "mines/game/grid.h"
+#include "mines/ui/cell_region.h"
+#include "mines/ui/mine_field_renderer.h"
+#include "mines/ui/resources.h"
+
+namespace mines {
+namespace bench {
+
+namespace {
+
+using ui::detail::Cell;
+using ui::detail::DrawingDimensions;
+
+// The cell size used when drawing, matching the default MineField cell size.
+constexpr std::size_t kCellSize = 20;
+
+// Fills the grid with a deterministic mix of cell appearances, similar to a
+// game in progress.
+void FillGrid(Grid<Cell>& grid) {
+  grid.ForEach([](std::size_t row, std::size_t col, Cell& cell) {
+    const std::size_t n = (row * 31 + col * 17) % 12;
+    if (n < 4) {
+      cell.state = CellState::COVERED;
+    } else if (n == 4) {
+      cell.state = CellState::FLAGGED;
+    } else {
+      cell.state = CellState::UNCOVERED;
+      cell.adjacent_mines = n - 4;
+    }
+  });
+}
+
+// Draws a full square board of Arg() rows and columns, as MineField::on_draw
+// does for a full expose.
+void BM_MineFieldDraw(State& state) {
+  const std::size_t size = state.Arg();
+  Grid<Cell> grid(size, size);
+  FillGrid(grid);
+
+  DrawingDimensions dim;
+  dim.x = 0;
+  dim.y = 0;
+  dim.cell_size = kCellSize;
+  dim.width = size * kCellSize + 2 * ui::detail::kFrameSize;
+  dim.height = dim.width;
+  const ui::detail::CellAtlas atlas(kCellSize,
+                                    ui::detail::LoadPixbufs(kCellSize));
+
+  Cairo::RefPtr<Cairo::ImageSurface> surface =
+      Cairo::ImageSurface::create(Cairo::FORMAT_RGB24, dim.width, dim.height);
+  Cairo::RefPtr<Cairo::Context> cr = Cairo::Context::create(surface);
+
+  while (state.KeepRunning()) {
+    ui::detail::DrawMineField(cr, dim, atlas, grid, 0, size - 1, 0, size - 1);
+    surface->flush();
+  }
+  state.SetItemsProcessed(state.MaxIterations() * size * size);
+}
+MINES_BENCHMARK(BM_MineFieldDraw)->Arg(16)->Arg(100)->Arg(500);
+
+// Renders the cell atlas at a cell size of Arg() pixels, as happens when a
+// resize changes the cell size.
+void BM_CellAtlasBuild(State& state) {
+  const std::size_t cell_size = state.Arg();
+  const ui::detail::Pixbufs pixbufs = ui::detail::LoadPixbufs(cell_size);
+  while (state.KeepRunning()) {
+    ui::detail::CellAtlas atlas(cell_size, pixbufs);
+    DoNotOptimize(atlas.GetCellSize());
+  }
+  state.SetItemsProcessed(state.MaxIterations());
+}
+MINES_BENCHMARK(BM_CellAtlasBuild)->Arg(20)->Arg(64);
+
+// Draws a 1000x1000 board from its color map at a cell size of Arg() pixels,
+// into a 1280x800 view of its top left corner, as MineField::on_draw does for
+// a full expose when zoomed out.
+void BM_ColorMapDraw(State& state) {
+  constexpr std::size_t kSize = 1000;
+  constexpr int kViewWidth = 1280;
+  constexpr int kViewHeight = 800;
+  Grid<Cell> grid(kSize, kSize);
+  FillGrid(grid);
+
+  ui::detail::CellColorMap color_map(kSize, kSize);
+  grid.ForEach([&color_map](std::size_t row, std::size_t col, Cell& cell) {
+    color_map.Draw(cell, row, col);
+  });
+
+  DrawingDimensions dim;
+  dim.x = 0;
+  dim.y = 0;
+  dim.cell_size = state.Arg();
+  dim.width = kSize * dim.cell_size + 2 * ui::detail::kFrameSize;
+  dim.height = dim.width;
+
+  Cairo::RefPtr<Cairo::ImageSurface> surface = Cairo::ImageSurface::create(
+      Cairo::FORMAT_RGB24, kViewWidth, kViewHeight);
+  Cairo::RefPtr<Cairo::Context> cr = Cairo::Context::create(surface);
+
+  while (state.KeepRunning()) {
+    ui::detail::DrawColorMapField(cr, dim, color_map);
+    surface->flush();
+  }
+  const std::size_t visible =
+      std::min<std::size_t>(kSize, kViewWidth / dim.cell_size) *
+      std::min<std::size_t>(kSize, kViewHeight / dim.cell_size);
+  state.SetItemsProcessed(state.MaxIterations() * visible);
+}
+MINES_BENCHMARK(BM_ColorMapDraw)->Arg(1)->Arg(2)->Arg(4);
+
+// Marks a diamond of cells spanning a square board of Arg() rows and columns
+// as dirty, as a large cascade does in one frame, then flushes it.
+void BM_DirtyRegionFlush(State& state) {
+  const std::size_t size = state.Arg();
+  const std::size_t center = size / 2;
+  ui::detail::DirtyRegion dirty;
+  dirty.Reset(size);
+  std::size_t cells = 0;
+  while (state.KeepRunning()) {
+    for (std::size_t row = 0; row < size; ++row) {
+      const std::size_t offset = row < center ? center - row : row - center;
+      for (std::size_t col = offset; col < size - offset; ++col) {
+        dirty.Include(row, col);
+        ++cells;
+      }
+    }
+    DoNotOptimize(dirty.Flush().size());
+  }
+  state.SetItemsProcessed(cells);
+}
+MINES_BENCHMARK(BM_DirtyRegionFlush)->Arg(16)->Arg(100)->Arg(1000);
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace mines
+
+int main(int argc, char* argv[]) {
+  // Allows gdkmm objects to be wrapped without opening a display.
+  Gtk::Main::init_gtkmm_internals();
+  ui_register_resource();
+  return mines::bench::RunBenchmarks(argc, argv);
+}
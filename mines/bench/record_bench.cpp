@@ -0,0 +1,127 @@
+// Benchmarks for writing and reading game records.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "mines/bench/benchmark.h"
+#include "mines/game/game.h"
+#include "mines/record/reader.h"
+#include "mines/record/writer.h"
+#include "mines/solver/solver.h"
+
+namespace mines {
+namespace bench {
+
+namespace {
+
+// The number of expert games in each recorded batch.
+constexpr std::size_t kGames = 256;
+
+// A temporary file that is removed when it goes out of scope.
+class TempFile {
+ public:
+  TempFile() {
+    char path[] = "/tmp/mines-record-bench-XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd >= 0) {
+      close(fd);
+      path_ = path;
+    }
+  }
+
+  ~TempFile() {
+    if (!path_.empty()) {
+      std::remove(path_.c_str());
+    }
+  }
+
+  const char* GetPath() const { return path_.c_str(); }
+
+ private:
+  std::string path_;
+};
+
+// Solves kGames expert games, recording them with writer if it is not null.
+void PlayGames(record::Writer* writer) {
+  for (unsigned seed = 0; seed < kGames; ++seed) {
+    std::unique_ptr<Game> game = NewGame(16, 30, 99, seed);
+    std::unique_ptr<solver::Solver> solver =
+        solver::New(solver::Algorithm::LOCAL, *game);
+    if (writer != nullptr) {
+      game->Subscribe(writer);
+    }
+    game->Execute(Action{Action::Type::UNCOVER, 8, 15});
+    std::vector<Action> actions;
+    do {
+      actions = solver->Analyze();
+      game->Execute(actions);
+    } while (!actions.empty());
+  }
+}
+
+// Records a batch of solved games. Comparing with BM_PlayGames gives the cost
+// of recording.
+void BM_RecordWrite(State& state) {
+  TempFile file;
+  while (state.KeepRunning()) {
+    std::unique_ptr<record::Writer> writer = record::NewWriter(file.GetPath());
+    PlayGames(writer.get());
+    writer->Flush();
+  }
+  state.SetItemsProcessed(state.MaxIterations() * kGames);
+}
+MINES_BENCHMARK(BM_RecordWrite);
+
+// Plays the same batch of games as BM_RecordWrite without recording them.
+void BM_PlayGames(State& state) {
+  while (state.KeepRunning()) {
+    PlayGames(nullptr);
+  }
+  state.SetItemsProcessed(state.MaxIterations() * kGames);
+}
+MINES_BENCHMARK(BM_PlayGames);
+
+// Reads a recorded batch of games, decoding every action and event. Items are
+// the decoded actions and events, and bytes are the size of the file.
+void BM_RecordRead(State& state) {
+  TempFile file;
+  {
+    std::unique_ptr<record::Writer> writer = record::NewWriter(file.GetPath());
+    PlayGames(writer.get());
+  }
+  std::unique_ptr<record::Reader> reader = record::NewReader(file.GetPath());
+
+  std::size_t entries = 0;
+  while (state.KeepRunning()) {
+    reader->Rewind();
+    record::Record r;
+    while (reader->Next(r)) {
+      record::ActionDecoder actions = r.Actions();
+      Action action;
+      while (actions.Next(action)) {
+        DoNotOptimize(action);
+        ++entries;
+      }
+      record::EventDecoder events = r.Events();
+      Event event;
+      while (events.Next(event)) {
+        DoNotOptimize(event);
+        ++entries;
+      }
+    }
+  }
+  state.SetItemsProcessed(entries);
+  state.SetBytesProcessed(state.MaxIterations() * reader->GetSize());
+}
+MINES_BENCHMARK(BM_RecordRead);
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace mines
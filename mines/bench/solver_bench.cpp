@@ -0,0 +1,123 @@
+// Benchmarks for the solvers.
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "mines/bench/benchmark.h"
+#include "mines/game/game.h"
+#include "mines/solver/local.h"
+#include "mines/solver/solver.h"
+
+namespace mines {
+namespace bench {
+
+namespace {
+
+// Board parameters for the solve benchmarks.
+struct Difficulty {
+  std::size_t rows;
+  std::size_t cols;
+  std::size_t mines;
+
+  // The number of games, with seeds 0 to games - 1, solved by each iteration
+  // of the solve benchmarks. Solving the same games every iteration keeps the
+  // work per iteration independent of the number of iterations.
+  unsigned games;
+};
+
+// Indexed by the benchmark argument: beginner, intermediate, expert, and a
+// large board with 10% mines.
+constexpr Difficulty kDifficulties[] = {
+    {8, 8, 10, 64},
+    {16, 16, 40, 64},
+    {16, 30, 99, 64},
+    {1000, 1000, 100000, 8},
+};
+
+// Records every event generated by a game.
+class EventRecorder : public EventSubscriber {
+ public:
+  void NotifyEvent(const Event& event) final { events_.push_back(event); }
+
+  const std::vector<Event>& GetEvents() const { return events_; }
+
+ private:
+  std::vector<Event> events_;
+};
+
+// Plays a game by uncovering the center cell and then executing the solver's
+// actions until it makes no more progress.
+void Solve(Game& game, solver::Solver& solver) {
+  game.Execute(
+      Action{Action::Type::UNCOVER, game.GetRows() / 2, game.GetCols() / 2});
+  std::vector<Action> actions;
+  do {
+    actions = solver.Analyze();
+    game.Execute(actions);
+  } while (!actions.empty());
+}
+
+// Feeds the events of a solved 1000x1000 game to a new local solver.
+void BM_LocalSolverNotifyEvent(State& state) {
+  const Difficulty& d = kDifficulties[3];
+
+  // Seed 2 opens a large area on the first click.
+  std::unique_ptr<Game> game = NewGame(d.rows, d.cols, d.mines, 2);
+  std::unique_ptr<solver::Solver> solver =
+      solver::New(solver::Algorithm::LOCAL, *game);
+  EventRecorder recorder;
+  game->Subscribe(&recorder);
+  Solve(*game, *solver);
+  const std::vector<Event>& events = recorder.GetEvents();
+
+  std::unique_ptr<solver::Solver> fresh_solver;
+  while (state.KeepRunning()) {
+    // Constructing the solver (and destroying the previous one) is not timed.
+    state.PauseTiming();
+    fresh_solver = solver::local::New(*game);
+    state.ResumeTiming();
+
+    for (const Event& event : events) {
+      fresh_solver->NotifyEvent(event);
+    }
+  }
+  state.SetItemsProcessed(state.MaxIterations() * events.size());
+}
+MINES_BENCHMARK(BM_LocalSolverNotifyEvent);
+
+// Solves games at the difficulty selected by Arg() with the local solver.
+void BM_SolveGame(State& state) {
+  const Difficulty& d = kDifficulties[state.Arg()];
+  while (state.KeepRunning()) {
+    for (unsigned seed = 0; seed < d.games; ++seed) {
+      std::unique_ptr<Game> game = NewGame(d.rows, d.cols, d.mines, seed);
+      std::unique_ptr<solver::Solver> solver =
+          solver::New(solver::Algorithm::LOCAL, *game);
+      Solve(*game, *solver);
+    }
+  }
+  state.SetItemsProcessed(state.MaxIterations() * d.games);
+}
+MINES_BENCHMARK(BM_SolveGame)->Arg(0)->Arg(1)->Arg(2)->Arg(3);
+
+// Solves games at the difficulty selected by Arg() with the tiered solver,
+// which plays each game to a win or a loss.
+void BM_SolveGameTiered(State& state) {
+  const Difficulty& d = kDifficulties[state.Arg()];
+  while (state.KeepRunning()) {
+    for (unsigned seed = 0; seed < d.games; ++seed) {
+      std::unique_ptr<Game> game = NewGame(d.rows, d.cols, d.mines, seed);
+      std::unique_ptr<solver::Solver> solver =
+          solver::New(solver::Algorithm::TIERED, *game);
+      Solve(*game, *solver);
+    }
+  }
+  state.SetItemsProcessed(state.MaxIterations() * d.games);
+}
+MINES_BENCHMARK(BM_SolveGameTiered)->Arg(0)->Arg(1)->Arg(2);
+
+}  // namespace
+
+}  // namespace bench
+}  // namespace mines
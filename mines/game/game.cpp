@@ -2,13 +2,21 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <queue>
 #include <random>
 #include <tuple>
+#include <unordered_set>
+#include <utility>
 
 #include "mines/compat/make_unique.h"
 #include "mines/game/grid.h"
+#include "mines/game/hash.h"
+#include "mines/game/instrumentation.h"
+#include "mines/game/tiled_grid.h"
 
 namespace mines {
 
@@ -50,17 +58,29 @@ constexpr Event IdentifyBadFlagEvent(std::size_t row, std::size_t col) {
   return Event{Event::Type::IDENTIFY_BAD_FLAG, row, col, 0};
 }
 
+// Convenience function to create a COVER event.
+constexpr Event CoverEvent(std::size_t row, std::size_t col,
+                           std::size_t adjacent_mines) {
+  return Event{Event::Type::COVER, row, col, adjacent_mines};
+}
+
 // A single cell in a game.
 class Cell {
  public:
+  Cell()
+      : is_mine_(false),
+        state_(COVERED),
+        adjacent_mines_(0),
+        adjacent_flags_(0) {}
+
   // Returns true if the cell contains a mine.
   bool IsMine() const { return is_mine_; }
 
   // Returns true if the cell is flagged.
-  bool IsFlagged() const { return state_ == State::FLAGGED; }
+  bool IsFlagged() const { return state_ == FLAGGED; }
 
   // Returns true if the cell is covered.
-  bool IsCovered() const { return state_ == State::COVERED; }
+  bool IsCovered() const { return state_ == COVERED; }
 
   // Sets this cell as a mine.
   //
@@ -77,17 +97,14 @@ class Cell {
   //
   // Returns false if the cell is uncovered.
   bool ToggleFlagged() {
-    if (state_ == State::UNCOVERED) {
-      return false;
-    }
     switch (state_) {
-      case State::COVERED:
-        state_ = State::FLAGGED;
+      case COVERED:
+        state_ = FLAGGED;
         return true;
-      case State::FLAGGED:
-        state_ = State::COVERED;
+      case FLAGGED:
+        state_ = COVERED;
         return true;
-      case State::UNCOVERED:
+      case UNCOVERED:
       default:
         return false;
     }
@@ -98,15 +115,35 @@ class Cell {
   // Returns false (and does nothing) if the cell is flagged or uncovered.
   bool Uncover() {
     // Cannot uncover cells that are flagged or already uncovered.
-    if (state_ == State::FLAGGED || state_ == State::UNCOVERED) {
+    if (state_ != COVERED) {
       return false;
     }
-    state_ = State::UNCOVERED;
+    state_ = UNCOVERED;
     return true;
   }
 
+  // Covers an uncovered cell. Used to undo Uncover.
+  void Cover() { state_ = COVERED; }
+
+  // Returns the number of adjacent mines. Only valid if the cell has been
+  // uncovered.
+  std::size_t GetAdjacentMines() const { return adjacent_mines_; }
+
+  // Records the number of adjacent mines when the cell is uncovered.
+  void SetAdjacentMines(std::size_t adjacent_mines) {
+    adjacent_mines_ = static_cast<std::uint8_t>(adjacent_mines);
+  }
+
+  // Returns the number of adjacent cells that are flagged.
+  std::size_t GetAdjacentFlags() const { return adjacent_flags_; }
+
+  // Adds one to or subtracts one from the number of adjacent flags.
+  void AddAdjacentFlag() { ++adjacent_flags_; }
+  void RemoveAdjacentFlag() { --adjacent_flags_; }
+
  private:
-  enum class State {
+  // The values of state_.
+  enum : std::uint8_t {
     // The cell is covered.
     COVERED,
 
@@ -117,43 +154,380 @@ class Cell {
     FLAGGED,
   };
 
-  bool is_mine_ = false;
-  State state_ = State::COVERED;
+  std::uint8_t is_mine_ : 1;
+  std::uint8_t state_ : 2;
+
+  // No count can exceed 8, so both fit in a single byte.
+  std::uint8_t adjacent_mines_ : 4;
+  std::uint8_t adjacent_flags_ : 4;
 };
 
-// The game implementation.
-class GameImpl : public Game {
+// Cells are kept small since snapshots copy the entire grid.
+static_assert(sizeof(Cell) == 2, "Cell should be two bytes");
+
+// A mine layout decides which cells of a game contain mines. GameImpl is
+// templated on its layout, which must provide:
+//
+//   // Places the mines in a new grid and chooses a backup cell that is not a
+//   // mine. Returns false if no backup cell could be found.
+//   bool Place(CellGrid& grid, std::size_t* backup_row,
+//              std::size_t* backup_col);
+//
+//   // Returns the number of mines reported by Game::GetMines.
+//   std::size_t GetMines() const;
+//
+//   // Returns true if uncovered is the number of cells without a mine, which
+//   // means the game has been won.
+//   bool IsCleared(const CellGrid& grid, std::size_t uncovered);
+//
+//   // Returns true if the cell contains a mine.
+//   bool IsMine(const CellGrid& grid, std::size_t row, std::size_t col) const;
+//
+//   // Exchanges the mine states of two cells, when the first cell uncovered
+//   // is a mine. Swapping the same cells again restores them.
+//   void Swap(CellGrid& grid, std::size_t row, std::size_t col,
+//             std::size_t other_row, std::size_t other_col);
+//
+//   // Calls fn(index) for each mine, where index is (row * cols + col), in
+//   // increasing order of index.
+//   void ForEachMine(const CellGrid& grid, Fn fn) const;
+//
+//   // Returns true if both layouts place the same mines.
+//   bool IsSameLayout(const Layout& other) const;
+//
+//   // The id reported by Game::GetMineGenerator.
+//   static constexpr std::uint16_t kGeneratorId;
+
+// Places an exact number of mines at locations chosen by a PRNG, and stores
+// them in the cells.
+//
+// The locations are also kept in a sorted list, so that the mines can be
+// visited without scanning the grid. The list only changes if the first click
+// is a mine, so copies of the layout share it until then.
+class StoredMines {
  public:
-  using Clock = std::chrono::steady_clock;
+  static constexpr std::uint16_t kGeneratorId = kMineGeneratorId;
+
+  StoredMines(std::size_t mines, unsigned seed) : mines_(mines), seed_(seed) {}
+
+  template <class CellGrid>
+  bool Place(CellGrid& grid, std::size_t* backup_row,
+             std::size_t* backup_col) {
+    const std::size_t rows = grid.GetRows();
+    const std::size_t cols = grid.GetCols();
 
-  GameImpl(std::size_t rows, std::size_t cols, std::size_t mines, unsigned seed)
-      : mines_(mines),
-        state_(State::NEW),
-        remaining_covered_(rows * cols - mines),
-        grid_(rows, cols) {
     // Assign the mines.
     std::default_random_engine g;
-    g.seed(seed);
+    g.seed(seed_);
     std::uniform_int_distribution<std::size_t> d(0, rows * cols - 1);
     auto rng = std::bind(d, g);
 
-    for (std::size_t remaining_mines = mines; remaining_mines > 0;) {
+    std::shared_ptr<std::vector<std::size_t>> list =
+        std::make_shared<std::vector<std::size_t>>();
+    list->reserve(mines_);
+    for (std::size_t remaining_mines = mines_; remaining_mines > 0;) {
       const std::size_t rnd = rng();
-      Cell& cell = grid_(rnd / cols, rnd % cols);
+      Cell& cell = grid(rnd / cols, rnd % cols);
       if (cell.SetMine()) {
+        list->push_back(rnd);
         --remaining_mines;
       }
     }
+    std::sort(list->begin(), list->end());
+    list_ = std::move(list);
 
     // Choose a backup cell to be a mine if the first cell uncovered is a mine.
+    // If every cell is a mine there is none to find. The backup is then a mine
+    // too, and swapping two untouched mines changes nothing, so the first cell
+    // uncovered loses.
+    if (mines_ == rows * cols) {
+      *backup_row = 0;
+      *backup_col = 0;
+      return true;
+    }
     do {
       const std::size_t rnd = rng();
-      backup_cell_ = &grid_(rnd / cols, rnd % cols);
-    } while (backup_cell_->IsMine());
+      *backup_row = rnd / cols;
+      *backup_col = rnd % cols;
+    } while (grid(*backup_row, *backup_col).IsMine());
+    return true;
+  }
+
+  std::size_t GetMines() const { return mines_; }
+
+  template <class CellGrid>
+  bool IsCleared(const CellGrid& grid, std::size_t uncovered) {
+    return uncovered == grid.GetRows() * grid.GetCols() - mines_;
+  }
+
+  template <class CellGrid>
+  bool IsMine(const CellGrid& grid, std::size_t row, std::size_t col) const {
+    return grid(row, col).IsMine();
+  }
+
+  template <class CellGrid>
+  void Swap(CellGrid& grid, std::size_t row, std::size_t col,
+            std::size_t other_row, std::size_t other_col) {
+    std::swap(grid(row, col), grid(other_row, other_col));
+    UpdateList(grid, row, col);
+    UpdateList(grid, other_row, other_col);
+  }
+
+  template <class CellGrid, class Fn>
+  void ForEachMine(const CellGrid& grid, Fn fn) const {
+    for (std::size_t index : *list_) {
+      fn(index);
+    }
+  }
+
+  bool IsSameLayout(const StoredMines& other) const {
+    return mines_ == other.mines_ && seed_ == other.seed_;
+  }
+
+ private:
+  // Adds or removes a cell from the list to match its mine state.
+  template <class CellGrid>
+  void UpdateList(const CellGrid& grid, std::size_t row, std::size_t col) {
+    if (list_.use_count() > 1) {
+      list_ = std::make_shared<std::vector<std::size_t>>(*list_);
+    }
+    std::vector<std::size_t>& list = *list_;
+    const std::size_t index = row * grid.GetCols() + col;
+    auto it = std::lower_bound(list.begin(), list.end(), index);
+    const bool listed = it != list.end() && *it == index;
+    if (grid(row, col).IsMine() && !listed) {
+      list.insert(it, index);
+    } else if (!grid(row, col).IsMine() && listed) {
+      list.erase(it);
+    }
+  }
+
+  std::size_t mines_;
+  unsigned seed_;
+
+  // The index (row * cols + col) of each mine, in increasing order. Shared
+  // with copies of the layout; a copy is made before it is modified.
+  std::shared_ptr<std::vector<std::size_t>> list_;
+};
+
+// Decides whether each cell is a mine from a hash of the seed and the cell's
+// location, so the mines are never stored. Each cell is a mine with
+// probability density, independently of the others.
+//
+// The only state is the mine moved by the first click and the progress of
+// counting the mines, so a game using this layout with a TiledGrid only stores
+// the cells that have been played.
+//
+// The mines are never counted up front. GetMines reports the expected number,
+// and the cells are only counted as far as win detection needs.
+class HashedMines {
+ public:
+  // Rows and columns must be less than kMaxDimension, so that the location
+  // hashed for a cell always has the top bit clear.
+  static constexpr std::size_t kMaxDimension = std::size_t{1} << 31;
+
+  // The number of cells tried as the backup before Place gives up.
+  static constexpr std::size_t kMaxBackupAttempts = 4096;
+
+  static constexpr std::uint16_t kGeneratorId = kHashedMineGeneratorId;
+
+  // The density must be in the range [0, 1).
+  HashedMines(double density, unsigned seed)
+      : density_(density),
+        key_(Mix64(seed)),
+        threshold_(static_cast<std::uint64_t>(density * kHashRange)) {}
+
+  // Placing the mines stores nothing and evaluates the hash only for the
+  // cells tried as the backup.
+  template <class CellGrid>
+  bool Place(CellGrid& grid, std::size_t* backup_row,
+             std::size_t* backup_col) {
+    const std::size_t rows = grid.GetRows();
+    const std::size_t cols = grid.GetCols();
+    mines_ = static_cast<std::size_t>(
+        std::llround(density_ * static_cast<double>(rows * cols)));
+
+    // Choose a backup cell from a sequence of hashes distinct from those used
+    // for the cells. The search is capped, since on a small board at a high
+    // density every cell may be a mine.
+    std::uint64_t counter = std::uint64_t{1} << 63;
+    for (std::size_t attempt = 0; attempt < kMaxBackupAttempts; ++attempt) {
+      const std::uint64_t rnd = Mix64(key_ ^ counter++);
+      *backup_row = (rnd >> 32) % rows;
+      *backup_col = (rnd & 0xffffffff) % cols;
+      if (!IsHashMine(*backup_row, *backup_col)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The expected number of mines, rounded to the nearest integer.
+  std::size_t GetMines() const { return mines_; }
+
+  // The cells without a mine are counted in row major order until there are
+  // more of them than uncovered, which rules out a win, or the board has been
+  // counted. The count is kept, so over a game it advances only as far as the
+  // cells uncovered, and the whole board is only counted for a game that is
+  // close to being won. Swapping mines does not change the total.
+  template <class CellGrid>
+  bool IsCleared(const CellGrid& grid, std::size_t uncovered) {
+    const std::size_t rows = grid.GetRows();
+    const std::size_t cols = grid.GetCols();
+    while (uncovered >= counted_safe_ && count_row_ < rows) {
+      if (!IsHashMine(count_row_, count_col_)) {
+        ++counted_safe_;
+      }
+      if (++count_col_ == cols) {
+        count_col_ = 0;
+        ++count_row_;
+      }
+    }
+    return count_row_ == rows && uncovered == counted_safe_;
+  }
+
+  template <class CellGrid>
+  bool IsMine(const CellGrid& grid, std::size_t row, std::size_t col) const {
+    if (swapped_) {
+      if (row == row_ && col == col_) {
+        return IsHashMine(other_row_, other_col_);
+      }
+      if (row == other_row_ && col == other_col_) {
+        return IsHashMine(row_, col_);
+      }
+    }
+    return IsHashMine(row, col);
+  }
+
+  // Only the one swap made by the first click needs to be represented, so a
+  // second swap is assumed to restore it.
+  template <class CellGrid>
+  void Swap(CellGrid& grid, std::size_t row, std::size_t col,
+            std::size_t other_row, std::size_t other_col) {
+    swapped_ = !swapped_;
+    row_ = row;
+    col_ = col;
+    other_row_ = other_row;
+    other_col_ = other_col;
+  }
+
+  // The mines are not stored, so only the cells stored in the grid are
+  // visited. For a Grid that is every cell; for a TiledGrid it is the area
+  // played.
+  template <class CellGrid, class Fn>
+  void ForEachMine(const CellGrid& grid, Fn fn) const {
+    std::vector<std::size_t> mines;
+    grid.ForEach(
+        [this, &grid, &mines](std::size_t row, std::size_t col, const Cell&) {
+          if (IsMine(grid, row, col)) {
+            mines.push_back(row * grid.GetCols() + col);
+          }
+        });
+    std::sort(mines.begin(), mines.end());
+    for (std::size_t index : mines) {
+      fn(index);
+    }
+  }
+
+  bool IsSameLayout(const HashedMines& other) const {
+    return key_ == other.key_ && threshold_ == other.threshold_;
+  }
+
+ private:
+  // Hashes are compared in the range [0, 2^53), which a double converts to
+  // exactly.
+  static constexpr double kHashRange = 9007199254740992.0;
+
+  // Returns true if the hash places a mine in the cell. The row is less than
+  // 2^31, so the top bit of the location is clear.
+  bool IsHashMine(std::size_t row, std::size_t col) const {
+    const std::uint64_t location = (static_cast<std::uint64_t>(row) << 32) |
+                                   static_cast<std::uint64_t>(col);
+    return (Mix64(key_ ^ location) >> 11) < threshold_;
+  }
+
+  double density_;
+  std::uint64_t key_;
+
+  // A cell is a mine if its hash, reduced to 53 bits, is below the threshold.
+  std::uint64_t threshold_;
+
+  // The expected number of mines, set by Place.
+  std::size_t mines_ = 0;
+
+  // The next cell to count, and the cells without a mine before it.
+  std::size_t count_row_ = 0;
+  std::size_t count_col_ = 0;
+  std::size_t counted_safe_ = 0;
+
+  // True if the cells below have had their mine states exchanged.
+  bool swapped_ = false;
+  std::size_t row_ = 0;
+  std::size_t col_ = 0;
+  std::size_t other_row_ = 0;
+  std::size_t other_col_ = 0;
+};
+
+constexpr std::uint16_t StoredMines::kGeneratorId;
+constexpr std::size_t HashedMines::kMaxDimension;
+constexpr std::uint16_t HashedMines::kGeneratorId;
+constexpr std::size_t HashedMines::kMaxBackupAttempts;
+constexpr double HashedMines::kHashRange;
+
+using Clock = std::chrono::steady_clock;
+
+// The state of a game, less its subscribers.
+template <class CellGrid, class MineLayout>
+class GameSnapshotImpl : public GameSnapshot {
+ public:
+  explicit GameSnapshotImpl(const MineLayout& layout) : layout(layout) {}
+
+  unsigned seed;
+  MineLayout layout;
+  Game::State state;
+  std::size_t uncovered;
+  CellGrid grid;
+  Grid<PlayerCell> view;
+  std::unordered_set<std::size_t> flags;
+  std::size_t backup_row;
+  std::size_t backup_col;
+  Clock::time_point start_time;
+  Clock::time_point end_time;
+  GameCounters counters;
+};
+
+// The game implementation.
+//
+// The cells are stored in a CellGrid, which is either a Grid or, for boards too
+// large to allocate up front, a TiledGrid. The MineLayout decides where the
+// mines are (see StoredMines and HashedMines).
+//
+// Boards stored in a Grid also keep a player view, updated as the events are
+// sent. It is not kept for a TiledGrid, where it would defeat the point of
+// sparse storage.
+template <class CellGrid, class MineLayout>
+class GameImpl : public Game {
+ public:
+  // The type of the snapshots taken of the game.
+  using SnapshotImpl = GameSnapshotImpl<CellGrid, MineLayout>;
+
+  GameImpl(std::size_t rows, std::size_t cols, const MineLayout& layout,
+           unsigned seed)
+      : layout_(layout),
+        seed_(seed),
+        state_(State::NEW),
+        grid_(rows, cols),
+        view_(rows * cols > kMaxDenseGridCells ? 0 : rows,
+              rows * cols > kMaxDenseGridCells ? 0 : cols) {
+    placed_ = layout_.Place(grid_, &backup_row_, &backup_col_);
   }
 
   ~GameImpl() final = default;
 
+  // Returns false if the layout could not choose a backup cell, in which case
+  // the game must not be played.
+  bool IsPlaced() const { return placed_; }
+
   void Execute(const Action& action) final {
     if (IsGameOver() || !grid_.IsValid(action.row, action.col)) {
       return;
@@ -163,7 +537,22 @@ class GameImpl : public Game {
       start_time_ = Clock::now();
     }
 
+    for (EventSubscriber* subscriber : subscribers_) {
+      subscriber->NotifyAction(action);
+    }
+
+    if (undo_enabled_) {
+      // Uncovering a mine on the first action moves the mine to the backup
+      // cell, which must be moved back on undo.
+      const bool swap = state_ == State::NEW &&
+                        action.type == Action::Type::UNCOVER &&
+                        IsMine(action.row, action.col);
+      journal_.push_back(JournalEntry{action, state_, uncovered_,
+                                      journal_events_.size(), swap});
+    }
+
     std::vector<Event> events;
+    cascade_cells_.clear();
     switch (action.type) {
       case Action::Type::UNCOVER:
         Uncover(action.row, action.col, events);
@@ -182,11 +571,28 @@ class GameImpl : public Game {
       state_ = State::PLAYING;
     }
 
-    for (const Event& event : events) {
-      for (EventSubscriber* subscriber : subscribers_) {
-        subscriber->NotifyEvent(event);
+    MINES_INSTRUMENT(UpdateCounters(events));
+
+    if (undo_enabled_) {
+      // Undo covers each cell of a cascade with its own event, so the journal
+      // needs one for each. The cells uncovered precede any other events.
+      const std::size_t cols = grid_.GetCols();
+      for (std::size_t index : cascade_cells_) {
+        const std::size_t row = index / cols;
+        const std::size_t col = index % cols;
+        journal_events_.push_back(
+            UncoverEvent(row, col, grid_(row, col).GetAdjacentMines()));
       }
+      journal_events_.insert(journal_events_.end(), events.begin(),
+                             events.end());
     }
+
+    if (!cascade_cells_.empty()) {
+      BuildCascade();
+      NotifyCascade();
+    }
+
+    Notify(events);
   }
 
   void Subscribe(EventSubscriber* subscriber) final {
@@ -198,7 +604,13 @@ class GameImpl : public Game {
 
   std::size_t GetCols() const final { return grid_.GetCols(); }
 
-  std::size_t GetMines() const final { return mines_; }
+  std::size_t GetMines() const final { return layout_.GetMines(); }
+
+  unsigned GetSeed() const final { return seed_; }
+
+  std::uint16_t GetMineGenerator() const final {
+    return MineLayout::kGeneratorId;
+  }
 
   State GetState() const final { return state_; }
 
@@ -215,6 +627,121 @@ class GameImpl : public Game {
     }
   }
 
+  const GameCounters& GetCounters() const final { return counters_; }
+
+  const Grid<PlayerCell>* GetPlayerView() const final {
+    return HasPlayerView() ? &view_ : nullptr;
+  }
+
+  std::unique_ptr<GameSnapshot> Snapshot() const final {
+    std::unique_ptr<SnapshotImpl> snapshot = MakeUnique<SnapshotImpl>(layout_);
+    snapshot->seed = seed_;
+    Save(*snapshot);
+    return std::move(snapshot);
+  }
+
+  bool Snapshot(GameSnapshot* snapshot) const final {
+    SnapshotImpl* s = dynamic_cast<SnapshotImpl*>(snapshot);
+    if (!IsSameGame(s)) {
+      return false;
+    }
+    Save(*s);
+    return true;
+  }
+
+  bool Restore(const GameSnapshot& snapshot) final {
+    const SnapshotImpl* s = dynamic_cast<const SnapshotImpl*>(&snapshot);
+    if (!IsSameGame(s)) {
+      return false;
+    }
+    state_ = s->state;
+    uncovered_ = s->uncovered;
+    layout_ = s->layout;
+    grid_ = s->grid;
+    view_ = s->view;
+    flags_ = s->flags;
+    backup_row_ = s->backup_row;
+    backup_col_ = s->backup_col;
+    start_time_ = s->start_time;
+    end_time_ = s->end_time;
+    counters_ = s->counters;
+    journal_.clear();
+    journal_events_.clear();
+    return true;
+  }
+
+  void SetUndoEnabled(bool enabled) final {
+    undo_enabled_ = enabled;
+    if (!enabled) {
+      journal_.clear();
+      journal_events_.clear();
+    }
+  }
+
+  void SetCascadeEventsEnabled(bool enabled) final {
+    cascade_events_enabled_ = enabled;
+  }
+
+  bool Undo() final {
+    if (journal_.empty()) {
+      return false;
+    }
+    const JournalEntry entry = journal_.back();
+    journal_.pop_back();
+
+    // Every change an action makes to a cell is described by one of its
+    // events, so walking them backwards restores the cells.
+    std::vector<Event> events;
+    for (std::size_t i = journal_events_.size(); i-- > entry.first_event;) {
+      const Event& event = journal_events_[i];
+      Cell& cell = grid_(event.row, event.col);
+      switch (event.type) {
+        case Event::Type::UNCOVER:
+          cell.Cover();
+          events.push_back(
+              CoverEvent(event.row, event.col, event.adjacent_mines));
+          break;
+        case Event::Type::FLAG:
+          cell.ToggleFlagged();
+          UpdateFlagIndex(event.row, event.col, false);
+          UpdateAdjacentFlags(event.row, event.col, false);
+          events.push_back(UnflagEvent(event.row, event.col));
+          break;
+        case Event::Type::UNFLAG:
+          cell.ToggleFlagged();
+          UpdateFlagIndex(event.row, event.col, true);
+          UpdateAdjacentFlags(event.row, event.col, true);
+          events.push_back(FlagEvent(event.row, event.col));
+          break;
+        case Event::Type::LOSS:
+          // The mine that was uncovered.
+          cell.Cover();
+          events.push_back(CoverEvent(event.row, event.col, 0));
+          break;
+        case Event::Type::IDENTIFY_MINE:
+          events.push_back(CoverEvent(event.row, event.col, 0));
+          break;
+        case Event::Type::IDENTIFY_BAD_FLAG:
+          events.push_back(FlagEvent(event.row, event.col));
+          break;
+        case Event::Type::WIN:
+        case Event::Type::COVER:
+          break;
+      }
+    }
+    journal_events_.resize(entry.first_event);
+
+    if (entry.swapped_backup) {
+      layout_.Swap(grid_, entry.action.row, entry.action.col, backup_row_,
+                   backup_col_);
+    }
+    state_ = entry.state;
+    uncovered_ = entry.uncovered;
+
+    Notify(events);
+    return true;
+  }
+
  private:
   // Attempts to uncover the specified cell.
   //
@@ -223,10 +750,8 @@ class GameImpl : public Game {
   // If the cell contains zero adjacent mines, the adjacent cells will be
   // recursively uncovered.
   void Uncover(std::size_t row, std::size_t col, std::vector<Event>& events) {
-    Cell& cell = grid_(row, col);
-
-    if (state_ == State::NEW && cell.IsMine()) {
-      std::swap(cell, *backup_cell_);
+    if (state_ == State::NEW && IsMine(row, col)) {
+      layout_.Swap(grid_, row, col, backup_row_, backup_col_);
     }
 
     UncoverAdjacent(row, col, true, events);
@@ -244,7 +769,7 @@ class GameImpl : public Game {
     }
 
     // Cannot chord if the the wrong number of cells are flagged.
-    if (CountAdjacentMines(row, col) != CountAdjacentFlagged(row, col)) {
+    if (cell.GetAdjacentMines() != cell.GetAdjacentFlags()) {
       return;
     }
 
@@ -258,24 +783,48 @@ class GameImpl : public Game {
                      std::vector<Event>& events) {
     Cell& cell = grid_(row, col);
     if (cell.ToggleFlagged()) {
+      UpdateFlagIndex(row, col, cell.IsFlagged());
+      UpdateAdjacentFlags(row, col, cell.IsFlagged());
       events.push_back(cell.IsFlagged() ? FlagEvent(row, col)
                                         : UnflagEvent(row, col));
     }
   }
 
-  // Counts the number of adjacent mines.
-  std::size_t CountAdjacentMines(std::size_t row, std::size_t col) const {
-    return grid_.ForEachAdjacent(row, col,
-                                 [this](std::size_t row, std::size_t col) {
-                                   return grid_(row, col).IsMine();
-                                 });
+  // Adds or removes a cell from the flag index.
+  void UpdateFlagIndex(std::size_t row, std::size_t col, bool flagged) {
+    const std::size_t index = row * grid_.GetCols() + col;
+    if (flagged) {
+      flags_.insert(index);
+    } else {
+      flags_.erase(index);
+    }
+  }
+
+  // Adds one to or subtracts one from the adjacent flag count of the cell's
+  // neighbors, after the cell is flagged or unflagged.
+  void UpdateAdjacentFlags(std::size_t row, std::size_t col, bool flagged) {
+    grid_.ForEachAdjacent(row, col,
+                          [this, flagged](std::size_t row, std::size_t col) {
+                            Cell& cell = grid_(row, col);
+                            if (flagged) {
+                              cell.AddAdjacentFlag();
+                            } else {
+                              cell.RemoveAdjacentFlag();
+                            }
+                            return false;
+                          });
   }
 
-  // Counts the number of adjacent flagged cells.
-  std::size_t CountAdjacentFlagged(std::size_t row, std::size_t col) const {
+  // Returns true if the cell contains a mine.
+  bool IsMine(std::size_t row, std::size_t col) const {
+    return layout_.IsMine(grid_, row, col);
+  }
+
+  // Counts the number of adjacent mines.
+  std::size_t CountAdjacentMines(std::size_t row, std::size_t col) const {
     return grid_.ForEachAdjacent(row, col,
                                  [this](std::size_t row, std::size_t col) {
-                                   return grid_(row, col).IsFlagged();
+                                   return IsMine(row, col);
                                  });
   }
 
@@ -286,6 +835,9 @@ class GameImpl : public Game {
   //
   // If an uncovered cell has zero adjacent mines, its adjacent cells will also
   // be uncovered.
+  //
+  // With cascade events enabled, the cells uncovered are recorded in
+  // cascade_cells_ rather than as UNCOVER events.
   void UncoverAdjacent(std::size_t row, std::size_t col, bool start_at_current,
                        std::vector<Event>& events) {
     std::queue<std::tuple<std::size_t, std::size_t>> uncover_queue;
@@ -312,17 +864,22 @@ class GameImpl : public Game {
       }
 
       // If a mine was uncovered this is a loss.
-      if (cell.IsMine()) {
+      if (IsMine(row, col)) {
         ShowAllMinesAndLose(row, col, events);
         return;
       }
 
       const std::size_t adjacent_mines = CountAdjacentMines(row, col);
-      events.push_back(UncoverEvent(row, col, adjacent_mines));
-      --remaining_covered_;
+      cell.SetAdjacentMines(adjacent_mines);
+      if (cascade_events_enabled_) {
+        cascade_cells_.push_back(row * grid_.GetCols() + col);
+      } else {
+        events.push_back(UncoverEvent(row, col, adjacent_mines));
+      }
+      ++uncovered_;
 
-      // If there are no more mines to uncover this is a win.
-      if (remaining_covered_ == 0) {
+      // If there are no more cells to uncover this is a win.
+      if (layout_.IsCleared(grid_, uncovered_)) {
         events.push_back(WinEvent(row, col));
         state_ = State::WIN;
         end_time_ = Clock::now();
@@ -338,42 +895,321 @@ class GameImpl : public Game {
 
   // Generates events to show all mines, followed by a lose event at the given
   // location.
+  //
+  // Only the mines and the flagged cells are visited, so the cost does not
+  // depend on the size of the board.
   void ShowAllMinesAndLose(std::size_t row, std::size_t col,
                            std::vector<Event>& events) {
-    grid_.ForEach(
-        [&events](std::size_t row, std::size_t col, const Cell& cell) {
-          if (cell.IsMine() && !cell.IsFlagged()) {
-            events.push_back(IdentifyMineEvent(row, col));
-          }
-          if (cell.IsFlagged() && !cell.IsMine()) {
-            events.push_back(IdentifyBadFlagEvent(row, col));
-          }
-        });
+    const std::size_t cols = grid_.GetCols();
+
+    std::vector<std::size_t> bad_flags;
+    for (std::size_t index : flags_) {
+      if (!IsMine(index / cols, index % cols)) {
+        bad_flags.push_back(index);
+      }
+    }
+    std::sort(bad_flags.begin(), bad_flags.end());
+
+    // The events are merged in row major order, as a scan of the grid would
+    // produce them.
+    auto bad_flag = bad_flags.begin();
+    auto identify_bad_flags_before = [cols, &bad_flag, &bad_flags,
+                                      &events](std::size_t index) {
+      for (; bad_flag != bad_flags.end() && *bad_flag < index; ++bad_flag) {
+        events.push_back(
+            IdentifyBadFlagEvent(*bad_flag / cols, *bad_flag % cols));
+      }
+    };
+    layout_.ForEachMine(grid_, [this, cols, &identify_bad_flags_before,
+                                &events](std::size_t index) {
+      identify_bad_flags_before(index);
+      if (!grid_(index / cols, index % cols).IsFlagged()) {
+        events.push_back(IdentifyMineEvent(index / cols, index % cols));
+      }
+    });
+    identify_bad_flags_before(grid_.GetRows() * cols);
 
     events.push_back(LossEvent(row, col));
     state_ = State::LOSS;
     end_time_ = Clock::now();
   }
 
-  const std::size_t mines_;
+  // Returns true if the player view is kept.
+  bool HasPlayerView() const { return view_.GetRows() != 0; }
+
+  // Sends events to all subscribers, updating the player view after each
+  // event has been sent.
+  void Notify(const std::vector<Event>& events) {
+    const bool has_view = HasPlayerView();
+    for (const Event& event : events) {
+      for (EventSubscriber* subscriber : subscribers_) {
+        subscriber->NotifyEvent(event);
+      }
+      if (has_view) {
+        UpdatePlayerCell(event, &view_(event.row, event.col));
+      }
+    }
+  }
+
+  // Fills cascade_ with the cells in cascade_cells_. The numbers were stored in
+  // the cells when they were uncovered.
+  //
+  // The cells are put in row major order by marking them in a bitmap of their
+  // bounding box. If the box is large compared to the number of cells, as it
+  // can be for a long diagonal opening, they are sorted instead.
+  void BuildCascade() {
+    cascade_.Clear();
+    const CellGrid& grid = grid_;
+    const std::size_t cols = grid.GetCols();
+    std::size_t min_row = cascade_cells_.front() / cols;
+    std::size_t max_row = min_row;
+    std::size_t min_col = cascade_cells_.front() % cols;
+    std::size_t max_col = min_col;
+    for (std::size_t index : cascade_cells_) {
+      min_row = std::min(min_row, index / cols);
+      max_row = std::max(max_row, index / cols);
+      min_col = std::min(min_col, index % cols);
+      max_col = std::max(max_col, index % cols);
+    }
+    const std::size_t count = cascade_cells_.size();
+    const std::size_t height = max_row - min_row + 1;
+    const std::size_t width = max_col - min_col + 1;
+
+    if (height > count * 64 / width) {
+      // Row major order is the order of the indices.
+      std::sort(cascade_cells_.begin(), cascade_cells_.end());
+      for (std::size_t index : cascade_cells_) {
+        const std::size_t row = index / cols;
+        const std::size_t col = index % cols;
+        cascade_.Add(row, col, grid(row, col).GetAdjacentMines());
+      }
+      return;
+    }
+
+    std::vector<std::uint64_t>& bits = cascade_bits_;
+    bits.assign((height * width + 63) / 64, 0);
+    for (std::size_t index : cascade_cells_) {
+      const std::size_t offset =
+          (index / cols - min_row) * width + (index % cols - min_col);
+      bits[offset / 64] |= std::uint64_t{1} << (offset % 64);
+    }
+
+    for (std::size_t row = min_row; row <= max_row; ++row) {
+      std::size_t offset = (row - min_row) * width;
+      for (std::size_t col = min_col; col <= max_col; ++col, ++offset) {
+        if ((bits[offset / 64] >> (offset % 64) & 1) != 0) {
+          cascade_.Add(row, col, grid(row, col).GetAdjacentMines());
+        }
+      }
+    }
+  }
+
+  // Sends cascade_ to all subscribers, then updates the player view.
+  void NotifyCascade() {
+    for (EventSubscriber* subscriber : subscribers_) {
+      subscriber->NotifyCascade(cascade_);
+    }
+    if (HasPlayerView()) {
+      cascade_.ForEach([this](std::size_t row, std::size_t col,
+                              std::size_t adjacent_mines) {
+        UpdatePlayerCell(UncoverEvent(row, col, adjacent_mines),
+                         &view_(row, col));
+      });
+    }
+  }
+
+  // Returns true if the snapshot was taken from a game of the same type with
+  // the same parameters and seed.
+  bool IsSameGame(const SnapshotImpl* s) const {
+    return s != nullptr && s->seed == seed_ &&
+           s->layout.IsSameLayout(layout_) &&
+           s->grid.GetRows() == grid_.GetRows() &&
+           s->grid.GetCols() == grid_.GetCols();
+  }
+
+  // Copies the mutable state of the game into the snapshot. Copying the grid
+  // reuses the snapshot's cells when it already has the right size.
+  void Save(SnapshotImpl& s) const {
+    s.state = state_;
+    s.uncovered = uncovered_;
+    s.layout = layout_;
+    s.grid = grid_;
+    s.view = view_;
+    s.flags = flags_;
+    s.backup_row = backup_row_;
+    s.backup_col = backup_col_;
+    s.start_time = start_time_;
+    s.end_time = end_time_;
+    s.counters = counters_;
+  }
+
+  // Updates the counters after an action has generated the given events and
+  // the cells in cascade_cells_.
+  void UpdateCounters(const std::vector<Event>& events) {
+    std::size_t revealed = cascade_cells_.size();
+    for (const Event& event : events) {
+      if (event.type == Event::Type::UNCOVER) {
+        ++revealed;
+      }
+    }
+
+    ++counters_.actions_executed;
+    counters_.events_emitted += events.size();
+    if (!cascade_cells_.empty()) {
+      // The cells are sent as one cascade.
+      ++counters_.events_emitted;
+    }
+    if (revealed > 0) {
+      ++counters_.cascades;
+      counters_.cells_revealed += revealed;
+      counters_.largest_cascade =
+          std::max(counters_.largest_cascade, revealed);
+    }
+  }
+
+  MineLayout layout_;
+  bool placed_;
+  const unsigned seed_;
   State state_;
-  std::size_t remaining_covered_;
-  Grid<Cell> grid_;
-  Cell* backup_cell_;
+
+  // The number of cells uncovered that are not mines.
+  std::size_t uncovered_ = 0;
+
+  CellGrid grid_;
+
+  // The player view, which is empty if it is not kept.
+  Grid<PlayerCell> view_;
+
+  // The index (row * cols + col) of each flagged cell, so that a loss can
+  // find the bad flags without scanning the grid.
+  std::unordered_set<std::size_t> flags_;
+
+  // The cell that a mine is moved to if the first cell uncovered is a mine.
+  std::size_t backup_row_;
+  std::size_t backup_col_;
+
   std::vector<EventSubscriber*> subscribers_;
 
+  // Whether uncovered cells are sent as a cascade, and the storage used to
+  // build it.
+  bool cascade_events_enabled_ = false;
+  Cascade cascade_;
+  std::vector<std::uint64_t> cascade_bits_;
+
+  // The index (row * cols + col) of each cell uncovered by the current action,
+  // in the order uncovered, when cascade events are enabled.
+  std::vector<std::size_t> cascade_cells_;
+
+  // The undo journal holds an entry for each action executed while undo is
+  // enabled. The events generated by the action are stored in journal_events_
+  // from first_event onwards.
+  struct JournalEntry {
+    Action action;
+    State state;
+    std::size_t uncovered;
+    std::size_t first_event;
+
+    // True if the action moved a mine to the backup cell.
+    bool swapped_backup;
+  };
+  bool undo_enabled_ = false;
+  std::vector<JournalEntry> journal_;
+  std::vector<Event> journal_events_;
+
   Clock::time_point start_time_;
   Clock::time_point end_time_;
+
+  GameCounters counters_;
 };
 
+// Creates a game, or returns nullptr if its layout could not be placed.
+template <class CellGrid, class MineLayout>
+std::unique_ptr<Game> NewGameImpl(std::size_t rows, std::size_t cols,
+                                  const MineLayout& layout, unsigned seed) {
+  std::unique_ptr<GameImpl<CellGrid, MineLayout>> game =
+      MakeUnique<GameImpl<CellGrid, MineLayout>>(rows, cols, layout, seed);
+  if (!game->IsPlaced()) {
+    return nullptr;
+  }
+  return std::move(game);
+}
+
 }  // namespace
 
+void EventSubscriber::NotifyCascade(const Cascade& cascade) {
+  cascade.ForEach(
+      [this](std::size_t row, std::size_t col, std::size_t adjacent_mines) {
+        NotifyEvent(UncoverEvent(row, col, adjacent_mines));
+      });
+}
+
+void UpdatePlayerCell(const Event& event, PlayerCell* cell) {
+  switch (event.type) {
+    case Event::Type::UNCOVER:
+      cell->state = CellState::UNCOVERED;
+      cell->adjacent_mines = static_cast<std::uint8_t>(event.adjacent_mines);
+      break;
+    case Event::Type::FLAG:
+      cell->state = CellState::FLAGGED;
+      break;
+    case Event::Type::UNFLAG:
+      cell->state = CellState::COVERED;
+      break;
+    case Event::Type::WIN:
+      break;
+    case Event::Type::LOSS:
+      cell->state = CellState::LOSING_MINE;
+      break;
+    case Event::Type::IDENTIFY_MINE:
+      cell->state = CellState::MINE;
+      break;
+    case Event::Type::IDENTIFY_BAD_FLAG:
+      cell->state = CellState::BAD_FLAG;
+      break;
+    case Event::Type::COVER:
+      cell->state = CellState::COVERED;
+      cell->adjacent_mines = 0;
+      break;
+  }
+}
+
+void PrintCounters(const GameCounters& counters, std::FILE* out) {
+  const double cells_per_cascade =
+      counters.cascades == 0
+          ? 0.0
+          : static_cast<double>(counters.cells_revealed) / counters.cascades;
+  std::fprintf(out, "game.actions_executed   %zu\n", counters.actions_executed);
+  std::fprintf(out, "game.events_emitted     %zu\n", counters.events_emitted);
+  std::fprintf(out, "game.cascades           %zu\n", counters.cascades);
+  std::fprintf(out, "game.cells_revealed     %zu\n", counters.cells_revealed);
+  std::fprintf(out, "game.cells_per_cascade  %.2f\n", cells_per_cascade);
+  std::fprintf(out, "game.largest_cascade    %zu\n", counters.largest_cascade);
+}
+
 std::unique_ptr<Game> NewGame(std::size_t rows, std::size_t cols,
                               std::size_t mines, unsigned seed) {
   if (rows == 0 || cols == 0 || mines > rows * cols) {
     return nullptr;
   }
-  return MakeUnique<GameImpl>(rows, cols, mines, seed);
+  const StoredMines layout(mines, seed);
+  if (rows * cols > kMaxDenseGridCells) {
+    return NewGameImpl<TiledGrid<Cell>>(rows, cols, layout, seed);
+  }
+  return NewGameImpl<Grid<Cell>>(rows, cols, layout, seed);
+}
+
+std::unique_ptr<Game> NewHashedGame(std::size_t rows, std::size_t cols,
+                                    double density, unsigned seed) {
+  if (rows == 0 || cols == 0 || rows >= HashedMines::kMaxDimension ||
+      cols >= HashedMines::kMaxDimension || !(density >= 0.0) ||
+      !(density < 1.0)) {
+    return nullptr;
+  }
+  const HashedMines layout(density, seed);
+  if (rows * cols > kMaxDenseGridCells) {
+    return NewGameImpl<TiledGrid<Cell>>(rows, cols, layout, seed);
+  }
+  return NewGameImpl<Grid<Cell>>(rows, cols, layout, seed);
 }
 
 }  // namespace mines
@@ -2,9 +2,13 @@
 #define MINES_GAME_GAME_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <memory>
 #include <vector>
 
+#include "mines/game/grid.h"
+
 namespace mines {
 
 // Represents the actions that may be performed in a Ui.
@@ -49,6 +53,11 @@ struct Event {
     // Identifies a location that was flagged but is not a mine. Only generated
     // when a game is lost.
     IDENTIFY_BAD_FLAG,
+
+    // A cell was returned to the covered state by Game::Undo. This retracts an
+    // UNCOVER, LOSS or IDENTIFY_MINE event for the cell. When it retracts an
+    // UNCOVER event, adjacent_mines is set as in the original event.
+    COVER,
   };
 
   // The type of event.
@@ -61,15 +70,84 @@ struct Event {
   std::size_t col;
 
   // The number of mines in adjacent cells.
-  // Only set for UNCOVERED events.
+  // Only set for UNCOVER events and the COVER events that retract them.
   std::size_t adjacent_mines;
 };
 
+// The cells uncovered by a single action, sent in place of their UNCOVER
+// events when a game has cascade events enabled (see
+// Game::SetCascadeEventsEnabled).
+//
+// The cells are stored as runs of consecutive cells in a row, in row major
+// order, with the number of adjacent mines of each cell in a separate buffer.
+// A large opening therefore takes a byte per cell and a few bytes per row,
+// rather than an Event per cell.
+class Cascade {
+ public:
+  // A run of consecutive cells in a row.
+  struct Run {
+    std::size_t row;
+    std::size_t col;
+    std::size_t length;
+  };
+
+  // Returns the runs of cells, in row major order.
+  const std::vector<Run>& GetRuns() const { return runs_; }
+
+  // Returns the number of adjacent mines of each cell, in the order of the
+  // cells in the runs.
+  const std::vector<std::uint8_t>& GetAdjacentMines() const {
+    return adjacent_mines_;
+  }
+
+  // Returns the number of cells.
+  std::size_t GetSize() const { return adjacent_mines_.size(); }
+
+  // Returns true if there are no cells.
+  bool IsEmpty() const { return adjacent_mines_.empty(); }
+
+  // Calls the provided function object for each cell, in row major order.
+  //
+  // The function should be callable as:
+  //   fn(row, col, adjacent_mines);
+  template <class Fn>
+  void ForEach(Fn fn) const {
+    const std::uint8_t* adjacent_mines = adjacent_mines_.data();
+    for (const Run& run : runs_) {
+      for (std::size_t col = run.col; col < run.col + run.length; ++col) {
+        fn(run.row, col, static_cast<std::size_t>(*adjacent_mines++));
+      }
+    }
+  }
+
+  // Removes all of the cells.
+  void Clear() {
+    runs_.clear();
+    adjacent_mines_.clear();
+  }
+
+  // Adds a cell, which must follow every cell already added in row major
+  // order.
+  void Add(std::size_t row, std::size_t col, std::size_t adjacent_mines) {
+    if (runs_.empty() || runs_.back().row != row ||
+        runs_.back().col + runs_.back().length != col) {
+      runs_.push_back(Run{row, col, 0});
+    }
+    ++runs_.back().length;
+    adjacent_mines_.push_back(static_cast<std::uint8_t>(adjacent_mines));
+  }
+
+ private:
+  std::vector<Run> runs_;
+  std::vector<std::uint8_t> adjacent_mines_;
+};
+
 // Represents the states that a cell can take from a player's point of view.
 //
 // This exists primarily as a convenience so that an equivalent does not need to
-// be redefined in each place knowledge about a cell is stored.
-enum class CellState {
+// be redefined in each place knowledge about a cell is stored. It is a single
+// byte so that it may be stored compactly in large grids.
+enum class CellState : std::uint8_t {
   // The cell is uncovered.
   UNCOVERED,
 
@@ -90,6 +168,57 @@ enum class CellState {
   BAD_FLAG,
 };
 
+// A cell as seen by the player: the knowledge a subscriber would otherwise
+// rebuild from the events it has received.
+struct PlayerCell {
+  // The state of the cell.
+  CellState state = CellState::COVERED;
+
+  // The number of adjacent mines.
+  // Only valid if the state is UNCOVERED.
+  std::uint8_t adjacent_mines = 0;
+};
+
+// Updates a player's view of a cell to reflect an event for that cell.
+void UpdatePlayerCell(const Event& event, PlayerCell* cell);
+
+// Counters describing the work done by a game.
+//
+// These are only maintained when the program is built with instrumentation
+// enabled (see mines/game/instrumentation.h). Otherwise they remain zero.
+struct GameCounters {
+  // The number of actions executed.
+  std::size_t actions_executed = 0;
+
+  // The number of events sent to subscribers. Each event is counted once
+  // regardless of the number of subscribers, and a cascade counts as one
+  // event.
+  std::size_t events_emitted = 0;
+
+  // The number of actions that uncovered at least one cell.
+  std::size_t cascades = 0;
+
+  // The total number of cells uncovered.
+  std::size_t cells_revealed = 0;
+
+  // The largest number of cells uncovered by a single action.
+  std::size_t largest_cascade = 0;
+
+  // Accumulates the counters from another game.
+  void Merge(const GameCounters& other) {
+    actions_executed += other.actions_executed;
+    events_emitted += other.events_emitted;
+    cascades += other.cascades;
+    cells_revealed += other.cells_revealed;
+    if (other.largest_cascade > largest_cascade) {
+      largest_cascade = other.largest_cascade;
+    }
+  }
+};
+
+// Writes a human readable dump of the counters.
+void PrintCounters(const GameCounters& counters, std::FILE* out);
+
 // Implementations of EventSubscriber may call Game::Subscribe to receive
 // event updates as actions are executed.
 class EventSubscriber {
@@ -101,8 +230,32 @@ class EventSubscriber {
   // Overriding this method is optional.
   virtual void NotifyEventSubscription(class Game* game) {}
 
+  // Notifies the subscriber that an action is being executed. This is called
+  // before any of the events generated by the action are sent.
+  //
+  // Actions that have no effect because the game is over or the location is
+  // invalid are not sent.
+  //
+  // Overriding this method is optional.
+  virtual void NotifyAction(const Action& action) {}
+
   // Notifies the subscriber that an event occurred.
   virtual void NotifyEvent(const Event& event) = 0;
+
+  // Notifies the subscriber that the cells of a cascade were uncovered. This is
+  // only sent by games with cascade events enabled, before any other events
+  // generated by the same action.
+  //
+  // Overriding this method is optional. By default NotifyEvent is called with
+  // an UNCOVER event for each cell, in the order of the cascade.
+  virtual void NotifyCascade(const Cascade& cascade);
+};
+
+// A copy of the state of a Game, created by Game::Snapshot. The contents are
+// private to the implementation.
+class GameSnapshot {
+ public:
+  virtual ~GameSnapshot() = default;
 };
 
 // The interface through which a game is played.
@@ -148,9 +301,18 @@ class Game {
   // Returns the number of columns in the game.
   virtual std::size_t GetCols() const = 0;
 
-  // Returns the number of mines in the game.
+  // Returns the number of mines in the game. For a game created by
+  // NewHashedGame this is the expected number of mines; the actual number
+  // typically differs from it by less than its square root.
   virtual std::size_t GetMines() const = 0;
 
+  // Returns the seed used to generate the mine locations.
+  virtual unsigned GetSeed() const = 0;
+
+  // Returns the id of the algorithm that placed the mines: kMineGeneratorId
+  // for NewGame, or kHashedMineGeneratorId for NewHashedGame.
+  virtual std::uint16_t GetMineGenerator() const = 0;
+
   // Returns the current game state.
   virtual State GetState() const = 0;
 
@@ -160,6 +322,72 @@ class Game {
   // If the game is over this value will no longer continue to change.
   virtual std::size_t GetElapsedSeconds() const = 0;
 
+  // Returns counters describing the work done by the game.
+  virtual const GameCounters& GetCounters() const = 0;
+
+  // Returns the board as seen by the player, or nullptr if the board is stored
+  // sparsely (see NewGame).
+  //
+  // The view is updated as events are sent: while subscribers are notified of
+  // an event, the view reflects every earlier event but not that one, so the
+  // previous state of the cell can still be read. A cascade counts as a single
+  // event. Subscribers that receive events as they are sent can read the view
+  // instead of keeping their own copy. It must only be read on the thread
+  // executing actions, so it is of no use to a subscriber that is passed the
+  // events later (see solver::NewUnsubscribed).
+  virtual const Grid<PlayerCell>* GetPlayerView() const = 0;
+
+  // Returns a copy of the current state of the game, including the mine
+  // locations but not the subscribers.
+  //
+  // Snapshots are intended for branching searches: a position can be saved,
+  // explored and restored many times without regenerating the game. Taking
+  // and restoring a snapshot costs a single copy of the board.
+  virtual std::unique_ptr<GameSnapshot> Snapshot() const = 0;
+
+  // Overwrites snapshot with the current state of the game, reusing its
+  // storage so that no memory is allocated. The snapshot must have been
+  // created by this game or another game with the same parameters and seed.
+  //
+  // Returns false (and does nothing) if the snapshot is from a different game.
+  virtual bool Snapshot(GameSnapshot* snapshot) const = 0;
+
+  // Returns the game to the state captured by snapshot, which must have been
+  // created by this game or another game with the same parameters and seed.
+  //
+  // Subscribers are not notified, so any state they derived from events will
+  // no longer match the game, although the player view is restored with it.
+  // The undo journal is cleared.
+  //
+  // Returns false (and does nothing) if the snapshot is from a different game.
+  virtual bool Restore(const GameSnapshot& snapshot) = 0;
+
+  // Starts or stops recording an undo journal of the changes made by each
+  // executed action. Stopping discards the journal. Recording is off by
+  // default.
+  virtual void SetUndoEnabled(bool enabled) = 0;
+
+  // Reverts the most recent action recorded in the undo journal. The time
+  // taken is proportional to the number of events the action generated.
+  //
+  // Subscribers are sent events retracting the action's events, in reverse
+  // order: FLAG and UNFLAG retract each other, IDENTIFY_BAD_FLAG is retracted
+  // by FLAG, and COVER retracts the rest. WIN events are not retracted; the
+  // game state simply returns to what it was. Counters are not rolled back.
+  //
+  // Returns false if there is no action to undo.
+  virtual bool Undo() = 0;
+
+  // Starts or stops sending the cells uncovered by each action as a single
+  // Cascade (see EventSubscriber::NotifyCascade) rather than as an UNCOVER
+  // event per cell. Disabled by default.
+  //
+  // The cells of a cascade are in row major order rather than the order in
+  // which they were uncovered, so the events of such a game cannot be replayed
+  // from a record (see record::Writer). Undo still sends a COVER event for each
+  // cell.
+  virtual void SetCascadeEventsEnabled(bool enabled) = 0;
+
   // Returns true if the game is over.
   bool IsGameOver() const {
     const State state = GetState();
@@ -167,7 +395,20 @@ class Game {
   }
 };
 
+// Identifies the algorithm NewGame uses to place mines for a given seed. A game
+// can only be reproduced from its seed by an engine with the same generator.
+constexpr std::uint16_t kMineGeneratorId = 1;
+
+// Identifies the algorithm NewHashedGame uses to place mines. The seed alone
+// does not describe such a game, so it cannot be recorded.
+constexpr std::uint16_t kHashedMineGeneratorId = 2;
+
 // Creates a new game.
+//
+// Boards larger than kMaxDenseGridCells (see mines/game/tiled_grid.h) are
+// stored sparsely, so their memory use grows with the number of mines and the
+// area played rather than the size of the board.
+//
 //   rows - The number of rows.
 //   cols - The number of columns.
 //   mines - The number of mines.
@@ -175,6 +416,30 @@ class Game {
 std::unique_ptr<Game> NewGame(std::size_t rows, std::size_t cols,
                               std::size_t mines, unsigned seed);
 
+// Creates a new game in which each cell is a mine with probability density,
+// decided by a hash of the seed and the cell's location.
+//
+// The mine locations are never stored or counted up front, so creating the
+// game takes constant time and on boards stored sparsely (see NewGame) memory
+// use grows only with the area played. GetMines reports the expected number of
+// mines. The cells are counted only as the game approaches a win, so detecting
+// the win costs time in proportion to the cells uncovered. When the game is
+// lost, only the mines in the area played are identified on a sparse board.
+//
+// Returns nullptr if the parameters are invalid, or if no cell without a mine
+// is found in 4096 tries to take the mine moved by the first click, which is
+// only likely when nearly every cell is a mine.
+//
+// The layout differs from that of NewGame, so these games cannot be reproduced
+// from a record.
+//
+//   rows - The number of rows, less than 2^31.
+//   cols - The number of columns, less than 2^31.
+//   density - The probability that a cell is a mine, in the range [0, 1).
+//   seed - Seed for the hash that decides the mine locations.
+std::unique_ptr<Game> NewHashedGame(std::size_t rows, std::size_t cols,
+                                    double density, unsigned seed);
+
 }  // namespace mines
 
 #endif  // MINES_GAME_GAME_H_
@@ -1,12 +1,16 @@
 #ifndef MINES_GAME_GRID_H_
 #define MINES_GAME_GRID_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <memory>
 
 namespace mines {
 
 // Represents a two dimensional grid of Cells.
+//
+// All of the cells are allocated up front. See TiledGrid for a sparse
+// alternative with the same interface.
 template <typename Cell>
 class Grid {
  public:
@@ -17,8 +21,18 @@ class Grid {
   ~Grid() = default;
 
   // Copyable.
-  Grid(const Grid&) = default;
-  Grid& operator=(const Grid&) = default;
+  Grid(const Grid& other) : Grid(other.rows_, other.cols_) {
+    CopyCells(other);
+  }
+  Grid& operator=(const Grid& other) {
+    if (this != &other) {
+      if (rows_ != other.rows_ || cols_ != other.cols_) {
+        Reset(other.rows_, other.cols_);
+      }
+      CopyCells(other);
+    }
+    return *this;
+  }
 
   // Movable.
   Grid(Grid&&) = default;
@@ -28,12 +42,7 @@ class Grid {
   void Reset(std::size_t rows, std::size_t cols) {
     rows_ = rows;
     cols_ = cols;
-    if (rows > 0 && cols > 0) {
-      cells_.reset(new std::unique_ptr<Cell[]>[rows]);
-      for (std::size_t row = 0; row < rows; ++row) {
-        cells_[row].reset(new Cell[cols]);
-      }
-    }
+    cells_.reset(rows > 0 && cols > 0 ? new Cell[rows * cols] : nullptr);
   }
 
   // Returns the number of rows.
@@ -49,23 +58,50 @@ class Grid {
 
   // Returns the Cell at the specified row and column.
   const Cell& operator()(std::size_t row, std::size_t col) const {
-    return cells_[row][col];
+    return cells_[row * cols_ + col];
   }
 
   // Returns the Cell at the specified row and column.
   Cell& operator()(std::size_t row, std::size_t col) {
-    return cells_[row][col];
+    return cells_[row * cols_ + col];
   }
 
+  // Returns the linear index of a cell. Cells are numbered in row major order.
+  std::size_t GetIndex(std::size_t row, std::size_t col) const {
+    return row * cols_ + col;
+  }
+
+  // Returns one more than the largest index returned by GetIndex.
+  std::size_t GetIndexLimit() const { return rows_ * cols_; }
+
+  // Returns the row of the cell with the specified linear index.
+  std::size_t GetRow(std::size_t index) const { return index / cols_; }
+
+  // Returns the column of the cell with the specified linear index.
+  std::size_t GetCol(std::size_t index) const { return index % cols_; }
+
   // Calls the provided function object for each Cell in the grid.
   //
   // The function should be callable as:
   //   fn(row, col, cell);
   template <class Fn>
   void ForEach(Fn fn) {
+    Cell* cell = cells_.get();
     for (std::size_t row = 0; row < rows_; ++row) {
       for (std::size_t col = 0; col < cols_; ++col) {
-        fn(row, col, cells_[row][col]);
+        fn(row, col, *cell++);
+      }
+    }
+  }
+
+  // Calls the provided function object for each Cell in the grid, without
+  // allowing the cells to be modified.
+  template <class Fn>
+  void ForEach(Fn fn) const {
+    const Cell* cell = cells_.get();
+    for (std::size_t row = 0; row < rows_; ++row) {
+      for (std::size_t col = 0; col < cols_; ++col) {
+        fn(row, col, *cell++);
       }
     }
   }
@@ -92,9 +128,18 @@ class Grid {
   }
 
  private:
+  // Copies the cells of a grid with the same dimensions.
+  void CopyCells(const Grid& other) {
+    std::copy(other.cells_.get(), other.cells_.get() + rows_ * cols_,
+              cells_.get());
+  }
+
   std::size_t rows_;
   std::size_t cols_;
-  std::unique_ptr<std::unique_ptr<Cell[]>[]> cells_;
+
+  // The cells in row major order, in a single allocation so that a grid can
+  // be copied in one pass.
+  std::unique_ptr<Cell[]> cells_;
 };
 
 }  // namespace mines
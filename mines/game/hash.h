@@ -0,0 +1,24 @@
+#ifndef MINES_GAME_HASH_H_
+#define MINES_GAME_HASH_H_
+
+#include <cstdint>
+
+namespace mines {
+
+// Mixes the bits of x so that each output bit depends on every input bit. This
+// is the finalizer of MurmurHash3.
+//
+// Hashed mine layouts (see NewHashedGame) depend on its exact output, so it
+// must not be changed.
+inline std::uint64_t Mix64(std::uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+}  // namespace mines
+
+#endif  // MINES_GAME_HASH_H_
@@ -0,0 +1,55 @@
+#ifndef MINES_GAME_INSTRUMENTATION_H_
+#define MINES_GAME_INSTRUMENTATION_H_
+
+#include <chrono>
+#include <cstdint>
+
+// Instrumentation is enabled by building with MINES_INSTRUMENTATION defined
+// (configure --enable-instrumentation).
+//
+// MINES_INSTRUMENT wraps code that maintains counters. When instrumentation is
+// disabled the wrapped code is removed entirely, so it costs nothing.
+#ifdef MINES_INSTRUMENTATION
+#define MINES_INSTRUMENT(...) __VA_ARGS__
+#else
+#define MINES_INSTRUMENT(...)
+#endif
+
+namespace mines {
+namespace instrumentation {
+
+// True if the program was built with instrumentation enabled.
+#ifdef MINES_INSTRUMENTATION
+constexpr bool kEnabled = true;
+#else
+constexpr bool kEnabled = false;
+#endif
+
+// Adds the lifetime of the timer, in nanoseconds, to a counter.
+//
+// Typical usage:
+//   MINES_INSTRUMENT(instrumentation::ScopedTimer timer(&counters_.time_ns));
+class ScopedTimer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit ScopedTimer(std::uint64_t* ns) : ns_(ns), start_(Clock::now()) {}
+
+  ~ScopedTimer() {
+    *ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                 start_)
+                .count();
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  std::uint64_t* ns_;
+  Clock::time_point start_;
+};
+
+}  // namespace instrumentation
+}  // namespace mines
+
+#endif  // MINES_GAME_INSTRUMENTATION_H_
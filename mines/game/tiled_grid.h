@@ -0,0 +1,296 @@
+#ifndef MINES_GAME_TILED_GRID_H_
+#define MINES_GAME_TILED_GRID_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+namespace mines {
+
+// Boards with more cells than this are stored in a TiledGrid rather than a
+// Grid by the game engine and the local solver.
+constexpr std::size_t kMaxDenseGridCells = std::size_t{1} << 24;
+
+// Represents a two dimensional grid of Cells, stored sparsely.
+//
+// The grid is divided into square tiles of 2^kTileBits cells on a side. A tile
+// is allocated the first time one of its cells is written, so memory scales
+// with the area that has been touched rather than the size of the grid. Cells
+// in tiles that have never been written read as a default constructed Cell.
+//
+// The interface matches Grid, so either may be used as the storage of a
+// component templated on its grid type. Only the non-const operator()
+// allocates.
+//
+// The most recently used tile is cached, so neighboring accesses avoid the
+// hash lookup. The cache is updated by const methods, so a TiledGrid must not
+// be read from multiple threads at once.
+template <typename Cell, unsigned kTileBits = 6>
+class TiledGrid {
+ public:
+  // The number of rows and columns in a tile.
+  static constexpr std::size_t kTileSize = std::size_t{1} << kTileBits;
+
+  // The number of cells in a tile.
+  static constexpr std::size_t kTileCells = kTileSize * kTileSize;
+
+  TiledGrid() : TiledGrid(0, 0) {}
+
+  TiledGrid(std::size_t rows, std::size_t cols) { Reset(rows, cols); }
+
+  ~TiledGrid() = default;
+
+  // Copyable. Only the allocated tiles are copied.
+  TiledGrid(const TiledGrid& other) : TiledGrid(other.rows_, other.cols_) {
+    CopyTiles(other);
+  }
+  TiledGrid& operator=(const TiledGrid& other) {
+    if (this != &other) {
+      if (rows_ != other.rows_ || cols_ != other.cols_) {
+        Reset(other.rows_, other.cols_);
+      }
+      CopyTiles(other);
+    }
+    return *this;
+  }
+
+  // Movable. The tiles themselves are not moved, so the cached tile remains
+  // valid.
+  TiledGrid(TiledGrid&& other) { *this = std::move(other); }
+  TiledGrid& operator=(TiledGrid&& other) {
+    if (this != &other) {
+      rows_ = other.rows_;
+      cols_ = other.cols_;
+      tile_cols_ = other.tile_cols_;
+      tiles_ = std::move(other.tiles_);
+      cached_key_ = other.cached_key_;
+      cached_tile_ = other.cached_tile_;
+      other.Reset(0, 0);
+    }
+    return *this;
+  }
+
+  // Resets the grid with new set of cells at the specified dimensions.
+  void Reset(std::size_t rows, std::size_t cols) {
+    rows_ = rows;
+    cols_ = cols;
+    tile_cols_ = (cols + kTileSize - 1) >> kTileBits;
+    tiles_.clear();
+    cached_key_ = kNoTile;
+    cached_tile_ = nullptr;
+  }
+
+  // Returns the number of rows.
+  std::size_t GetRows() const { return rows_; }
+
+  // Returns the number of columns.
+  std::size_t GetCols() const { return cols_; }
+
+  // Returns true if the given row and column are valid.
+  bool IsValid(std::size_t row, std::size_t col) const {
+    return row < rows_ && col < cols_;
+  }
+
+  // Returns the Cell at the specified row and column.
+  //
+  // Does not allocate; a cell in a tile that has not been allocated is
+  // returned as a shared default constructed Cell.
+  const Cell& operator()(std::size_t row, std::size_t col) const {
+    const Cell* tile = FindTile(GetTileKey(row, col));
+    return tile != nullptr ? tile[GetOffset(row, col)] : DefaultCell();
+  }
+
+  // Returns the Cell at the specified row and column, allocating its tile if
+  // necessary.
+  Cell& operator()(std::size_t row, std::size_t col) {
+    const std::size_t key = GetTileKey(row, col);
+    Cell* tile = FindTile(key);
+    if (tile == nullptr) {
+      tile = AllocateTile(key);
+    }
+    return tile[GetOffset(row, col)];
+  }
+
+  // Returns the linear index of a cell. Cells are numbered tile by tile, so
+  // the cells of a tile have consecutive indices.
+  std::size_t GetIndex(std::size_t row, std::size_t col) const {
+    return (GetTileKey(row, col) << (2 * kTileBits)) | GetOffset(row, col);
+  }
+
+  // Returns one more than the largest index returned by GetIndex.
+  std::size_t GetIndexLimit() const {
+    return ((rows_ + kTileSize - 1) >> kTileBits) * tile_cols_ * kTileCells;
+  }
+
+  // Returns the row of the cell with the specified linear index.
+  std::size_t GetRow(std::size_t index) const {
+    const std::size_t tile_row = (index >> (2 * kTileBits)) / tile_cols_;
+    return (tile_row << kTileBits) | ((index >> kTileBits) & (kTileSize - 1));
+  }
+
+  // Returns the column of the cell with the specified linear index.
+  std::size_t GetCol(std::size_t index) const {
+    const std::size_t tile_col = (index >> (2 * kTileBits)) % tile_cols_;
+    return (tile_col << kTileBits) | (index & (kTileSize - 1));
+  }
+
+  // Returns the number of tiles that have been allocated.
+  std::size_t GetTileCount() const { return tiles_.size(); }
+
+  // Calls the provided function object for each Cell in an allocated tile.
+  // Cells are visited tile by tile, in an unspecified order of tiles.
+  //
+  // The function should be callable as:
+  //   fn(row, col, cell);
+  template <class Fn>
+  void ForEach(Fn fn) {
+    for (auto& tile : tiles_) {
+      const std::size_t min_row = (tile.first / tile_cols_) << kTileBits;
+      const std::size_t min_col = (tile.first % tile_cols_) << kTileBits;
+      const std::size_t max_row = std::min(min_row + kTileSize, rows_);
+      const std::size_t max_col = std::min(min_col + kTileSize, cols_);
+      for (std::size_t row = min_row; row < max_row; ++row) {
+        Cell* cell = &tile.second[(row - min_row) << kTileBits];
+        for (std::size_t col = min_col; col < max_col; ++col) {
+          fn(row, col, *cell++);
+        }
+      }
+    }
+  }
+
+  // Calls the provided function object for each Cell in an allocated tile,
+  // without allowing the cells to be modified.
+  template <class Fn>
+  void ForEach(Fn fn) const {
+    for (const auto& tile : tiles_) {
+      const std::size_t min_row = (tile.first / tile_cols_) << kTileBits;
+      const std::size_t min_col = (tile.first % tile_cols_) << kTileBits;
+      const std::size_t max_row = std::min(min_row + kTileSize, rows_);
+      const std::size_t max_col = std::min(min_col + kTileSize, cols_);
+      for (std::size_t row = min_row; row < max_row; ++row) {
+        const Cell* cell = &tile.second[(row - min_row) << kTileBits];
+        for (std::size_t col = min_col; col < max_col; ++col) {
+          fn(row, col, *cell++);
+        }
+      }
+    }
+  }
+
+  // Calls the provided function object for each of the valid adjacent cells.
+  //
+  // The function should be callable as:
+  //   bool v = fn(row, col);
+  //
+  // Returns the number of function calls that returned true.
+  template <class Fn>
+  std::size_t ForEachAdjacent(std::size_t row, std::size_t col, Fn fn) const {
+    // Note: This relies on the fact that unsigned underflow is well defined.
+    //
+    // The neighbors are visited in the same order as Grid. Neighbors that lie
+    // in another tile are handled by the lookup in operator().
+    std::size_t count = 0;
+    count += IsValid(row - 1, col - 1) && fn(row - 1, col - 1) ? 1 : 0;
+    count += IsValid(row - 1, col - 0) && fn(row - 1, col - 0) ? 1 : 0;
+    count += IsValid(row - 1, col + 1) && fn(row - 1, col + 1) ? 1 : 0;
+    count += IsValid(row - 0, col - 1) && fn(row - 0, col - 1) ? 1 : 0;
+    count += IsValid(row + 1, col + 1) && fn(row + 1, col + 1) ? 1 : 0;
+    count += IsValid(row + 1, col - 0) && fn(row + 1, col - 0) ? 1 : 0;
+    count += IsValid(row + 1, col - 1) && fn(row + 1, col - 1) ? 1 : 0;
+    count += IsValid(row - 0, col + 1) && fn(row - 0, col + 1) ? 1 : 0;
+    return count;
+  }
+
+ private:
+  // A key that no tile has.
+  static constexpr std::size_t kNoTile = ~std::size_t{0};
+
+  // Returns the shared Cell returned for unallocated tiles.
+  static const Cell& DefaultCell() {
+    static const Cell cell{};
+    return cell;
+  }
+
+  // Returns the key of the tile containing a cell.
+  std::size_t GetTileKey(std::size_t row, std::size_t col) const {
+    return (row >> kTileBits) * tile_cols_ + (col >> kTileBits);
+  }
+
+  // Returns the offset of a cell within its tile.
+  static std::size_t GetOffset(std::size_t row, std::size_t col) {
+    return ((row & (kTileSize - 1)) << kTileBits) | (col & (kTileSize - 1));
+  }
+
+  // Returns the cells of a tile, or nullptr if it has not been allocated.
+  Cell* FindTile(std::size_t key) const {
+    if (key != cached_key_) {
+      auto it = tiles_.find(key);
+      if (it == tiles_.end()) {
+        return nullptr;
+      }
+      cached_key_ = key;
+      cached_tile_ = it->second.get();
+    }
+    return cached_tile_;
+  }
+
+  // Allocates a tile of default constructed cells.
+  Cell* AllocateTile(std::size_t key) {
+    std::unique_ptr<Cell[]>& tile = tiles_[key];
+    tile.reset(new Cell[kTileCells]());
+    cached_key_ = key;
+    cached_tile_ = tile.get();
+    return cached_tile_;
+  }
+
+  // Copies the tiles of a grid with the same dimensions. Tiles allocated in
+  // both grids are reused, so copying between grids that have touched the
+  // same area allocates nothing.
+  void CopyTiles(const TiledGrid& other) {
+    for (auto it = tiles_.begin(); it != tiles_.end();) {
+      if (other.tiles_.count(it->first) == 0) {
+        it = tiles_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    cached_key_ = kNoTile;
+    cached_tile_ = nullptr;
+
+    for (const auto& tile : other.tiles_) {
+      Cell* cells = FindTile(tile.first);
+      if (cells == nullptr) {
+        cells = AllocateTile(tile.first);
+      }
+      std::copy(tile.second.get(), tile.second.get() + kTileCells, cells);
+    }
+  }
+
+  std::size_t rows_;
+  std::size_t cols_;
+
+  // The number of tiles in each row of tiles.
+  std::size_t tile_cols_;
+
+  // The allocated tiles, keyed by (tile row * tile_cols_ + tile column). Each
+  // tile holds its cells in row major order.
+  std::unordered_map<std::size_t, std::unique_ptr<Cell[]>> tiles_;
+
+  // The most recently found tile.
+  mutable std::size_t cached_key_;
+  mutable Cell* cached_tile_;
+};
+
+template <typename Cell, unsigned kTileBits>
+constexpr std::size_t TiledGrid<Cell, kTileBits>::kTileSize;
+
+template <typename Cell, unsigned kTileBits>
+constexpr std::size_t TiledGrid<Cell, kTileBits>::kTileCells;
+
+template <typename Cell, unsigned kTileBits>
+constexpr std::size_t TiledGrid<Cell, kTileBits>::kNoTile;
+
+}  // namespace mines
+
+#endif  // MINES_GAME_TILED_GRID_H_
@@ -0,0 +1,137 @@
+#ifndef MINES_RECORD_FORMAT_H_
+#define MINES_RECORD_FORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mines/game/game.h"
+
+namespace mines {
+namespace record {
+
+// A record file is a sequence of game records. Each record is a fixed size
+// header followed by an action stream and an optional event stream.
+//
+// All multi-byte header fields are little endian:
+//
+//   offset  size  field
+//        0     4  magic ("MREC")
+//        4     2  format version
+//        6     2  mine generator id (see kMineGeneratorId)
+//        8     4  rows
+//       12     4  cols
+//       16     4  mines
+//       20     4  seed
+//       24     1  flags (kHasEvents)
+//       25     1  final game state (Game::State)
+//       26     2  reserved (zero)
+//       28     4  number of actions
+//       32     4  number of events
+//       36     4  size of the action stream in bytes
+//       40     4  size of the event stream in bytes
+//
+// Cells are identified by their linear index (row * cols + col). Both streams
+// encode each entry relative to the previous entry's index, which keeps most
+// entries to one or two bytes:
+//
+//   action: varint((zigzag(index - previous_index) << 2) | action type)
+//   event:  varint((zigzag(index - previous_index) << 3) | event type)
+//           followed, for UNCOVER events only, by one byte holding the number
+//           of adjacent mines.
+//
+// The previous index starts at zero for each stream of each record.
+
+// The magic number at the start of each record.
+constexpr std::uint32_t kMagic = 0x4345524d;  // "MREC"
+
+// The current format version.
+constexpr std::uint16_t kVersion = 1;
+
+// The size of a record header in bytes.
+constexpr std::size_t kHeaderSize = 44;
+
+// Header flag indicating that the record includes an event stream.
+constexpr std::uint8_t kHasEvents = 1;
+
+// The decoded header of a record.
+struct Header {
+  std::uint16_t version;
+  std::uint16_t generator;
+  std::uint32_t rows;
+  std::uint32_t cols;
+  std::uint32_t mines;
+  std::uint32_t seed;
+  std::uint8_t flags;
+  Game::State state;
+  std::uint32_t action_count;
+  std::uint32_t event_count;
+  std::uint32_t action_bytes;
+  std::uint32_t event_bytes;
+};
+
+// Maps a signed value to an unsigned value such that values of small
+// magnitude have small encodings.
+inline std::uint64_t ZigZagEncode(std::int64_t value) {
+  return (static_cast<std::uint64_t>(value) << 1) ^
+         static_cast<std::uint64_t>(value >> 63);
+}
+
+// Reverses ZigZagEncode.
+inline std::int64_t ZigZagDecode(std::uint64_t value) {
+  return static_cast<std::int64_t>(value >> 1) ^
+         -static_cast<std::int64_t>(value & 1);
+}
+
+// Appends a variable length (LEB128) encoding of value.
+inline void PutVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<std::uint8_t>(value));
+}
+
+// Decodes a varint from [*pos, end), advancing *pos past it.
+//
+// Returns false if the varint is truncated or too long.
+inline bool GetVarint(const std::uint8_t** pos, const std::uint8_t* end,
+                      std::uint64_t* value) {
+  std::uint64_t result = 0;
+  for (unsigned shift = 0; shift < 64 && *pos < end; shift += 7) {
+    const std::uint8_t byte = *(*pos)++;
+    result |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Appends a little endian encoding of a 16 bit value.
+inline void PutFixed16(std::vector<std::uint8_t>& out, std::uint16_t value) {
+  out.push_back(static_cast<std::uint8_t>(value));
+  out.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+// Appends a little endian encoding of a 32 bit value.
+inline void PutFixed32(std::vector<std::uint8_t>& out, std::uint32_t value) {
+  PutFixed16(out, static_cast<std::uint16_t>(value));
+  PutFixed16(out, static_cast<std::uint16_t>(value >> 16));
+}
+
+// Decodes a little endian 16 bit value.
+inline std::uint16_t GetFixed16(const std::uint8_t* p) {
+  return static_cast<std::uint16_t>(p[0] | p[1] << 8);
+}
+
+// Decodes a little endian 32 bit value.
+inline std::uint32_t GetFixed32(const std::uint8_t* p) {
+  return GetFixed16(p) | static_cast<std::uint32_t>(GetFixed16(p + 2)) << 16;
+}
+
+}  // namespace record
+}  // namespace mines
+
+#endif  // MINES_RECORD_FORMAT_H_
@@ -0,0 +1,155 @@
+#include "mines/record/reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mines/compat/make_unique.h"
+
+namespace mines {
+namespace record {
+
+namespace {
+
+// The number of action and event types, used to validate decoded types.
+constexpr std::uint64_t kActionTypes =
+    static_cast<std::uint64_t>(Action::Type::FLAG) + 1;
+constexpr std::uint64_t kEventTypes =
+    static_cast<std::uint64_t>(Event::Type::COVER) + 1;
+
+class ReaderImpl : public Reader {
+ public:
+  ReaderImpl(const std::uint8_t* data, std::size_t size)
+      : data_(data), size_(size), pos_(data) {}
+
+  ~ReaderImpl() final {
+    if (size_ > 0) {
+      munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+  }
+
+  bool Next(Record& record) final {
+    const std::uint8_t* end = data_ + size_;
+    if (pos_ == end || corrupt_) {
+      return false;
+    }
+    if (static_cast<std::size_t>(end - pos_) < kHeaderSize ||
+        GetFixed32(pos_) != kMagic || GetFixed16(pos_ + 4) != kVersion) {
+      corrupt_ = true;
+      return false;
+    }
+
+    Header& h = record.header;
+    h.version = GetFixed16(pos_ + 4);
+    h.generator = GetFixed16(pos_ + 6);
+    h.rows = GetFixed32(pos_ + 8);
+    h.cols = GetFixed32(pos_ + 12);
+    h.mines = GetFixed32(pos_ + 16);
+    h.seed = GetFixed32(pos_ + 20);
+    h.flags = pos_[24];
+    h.state = static_cast<Game::State>(pos_[25]);
+    h.action_count = GetFixed32(pos_ + 28);
+    h.event_count = GetFixed32(pos_ + 32);
+    h.action_bytes = GetFixed32(pos_ + 36);
+    h.event_bytes = GetFixed32(pos_ + 40);
+
+    const std::uint64_t payload =
+        static_cast<std::uint64_t>(h.action_bytes) + h.event_bytes;
+    // A board holds at most rows * cols mines, which cannot overflow as the
+    // dimensions are 32 bits.
+    if (h.rows == 0 || h.cols == 0 ||
+        h.mines > static_cast<std::uint64_t>(h.rows) * h.cols ||
+        payload > static_cast<std::uint64_t>(end - pos_) - kHeaderSize) {
+      corrupt_ = true;
+      return false;
+    }
+
+    record.actions = pos_ + kHeaderSize;
+    record.events = record.actions + h.action_bytes;
+    pos_ = record.events + h.event_bytes;
+    return true;
+  }
+
+  void Rewind() final {
+    pos_ = data_;
+    corrupt_ = false;
+  }
+
+  bool IsCorrupt() const final { return corrupt_; }
+
+  std::size_t GetSize() const final { return size_; }
+
+ private:
+  const std::uint8_t* const data_;
+  const std::size_t size_;
+  const std::uint8_t* pos_;
+  bool corrupt_ = false;
+};
+
+}  // namespace
+
+bool ActionDecoder::Next(Action& action) {
+  std::uint64_t value;
+  if (pos_ == end_ || !GetVarint(&pos_, end_, &value) ||
+      (value & 3) >= kActionTypes) {
+    pos_ = end_;
+    return false;
+  }
+  index_ += static_cast<std::uint64_t>(ZigZagDecode(value >> 2));
+  action.type = static_cast<Action::Type>(value & 3);
+  action.row = index_ / cols_;
+  action.col = index_ % cols_;
+  return true;
+}
+
+bool EventDecoder::Next(Event& event) {
+  std::uint64_t value;
+  if (pos_ == end_ || !GetVarint(&pos_, end_, &value) ||
+      (value & 7) >= kEventTypes) {
+    pos_ = end_;
+    return false;
+  }
+  index_ += static_cast<std::uint64_t>(ZigZagDecode(value >> 3));
+  event.type = static_cast<Event::Type>(value & 7);
+  event.row = index_ / cols_;
+  event.col = index_ % cols_;
+  event.adjacent_mines = 0;
+  if (event.type == Event::Type::UNCOVER) {
+    if (pos_ == end_) {
+      return false;
+    }
+    event.adjacent_mines = *pos_++;
+  }
+  return true;
+}
+
+std::unique_ptr<Reader> NewReader(const char* path) {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  const std::size_t size = static_cast<std::size_t>(st.st_size);
+  void* data = nullptr;
+  if (size > 0) {
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return nullptr;
+    }
+    // Records are almost always read front to back.
+    madvise(data, size, MADV_SEQUENTIAL);
+  }
+  // The mapping remains valid after the descriptor is closed.
+  close(fd);
+  return MakeUnique<ReaderImpl>(static_cast<const std::uint8_t*>(data), size);
+}
+
+}  // namespace record
+}  // namespace mines
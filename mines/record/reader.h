@@ -0,0 +1,106 @@
+#ifndef MINES_RECORD_READER_H_
+#define MINES_RECORD_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "mines/game/game.h"
+#include "mines/record/format.h"
+
+namespace mines {
+namespace record {
+
+// Decodes the action stream of a record.
+class ActionDecoder {
+ public:
+  ActionDecoder() = default;
+  ActionDecoder(const std::uint8_t* begin, const std::uint8_t* end,
+                std::uint32_t cols)
+      : pos_(begin), end_(end), cols_(cols) {}
+
+  // Decodes the next action into action.
+  //
+  // Returns false at the end of the stream or if the stream is corrupt.
+  bool Next(Action& action);
+
+ private:
+  const std::uint8_t* pos_ = nullptr;
+  const std::uint8_t* end_ = nullptr;
+  std::uint32_t cols_ = 0;
+  std::uint64_t index_ = 0;
+};
+
+// Decodes the event stream of a record.
+class EventDecoder {
+ public:
+  EventDecoder() = default;
+  EventDecoder(const std::uint8_t* begin, const std::uint8_t* end,
+               std::uint32_t cols)
+      : pos_(begin), end_(end), cols_(cols) {}
+
+  // Decodes the next event into event.
+  //
+  // Returns false at the end of the stream or if the stream is corrupt.
+  bool Next(Event& event);
+
+ private:
+  const std::uint8_t* pos_ = nullptr;
+  const std::uint8_t* end_ = nullptr;
+  std::uint32_t cols_ = 0;
+  std::uint64_t index_ = 0;
+};
+
+// A view of one record in a mapped file. It is only valid while the Reader it
+// came from exists.
+struct Record {
+  Header header;
+
+  // Returns a decoder for the record's actions.
+  ActionDecoder Actions() const {
+    return ActionDecoder(actions, actions + header.action_bytes, header.cols);
+  }
+
+  // Returns a decoder for the record's events. The decoder is empty if the
+  // record has no event stream.
+  EventDecoder Events() const {
+    return EventDecoder(events, events + header.event_bytes, header.cols);
+  }
+
+  const std::uint8_t* actions;
+  const std::uint8_t* events;
+};
+
+// Reads the records in a file written by a Writer.
+//
+// The file is mapped into memory, so iterating over records copies nothing
+// and records can be skipped without decoding their streams.
+class Reader {
+ public:
+  virtual ~Reader() = default;
+
+  // Reads the header of the next record into record.
+  //
+  // Returns false at the end of the file or if the next record is corrupt.
+  virtual bool Next(Record& record) = 0;
+
+  // Returns to the first record.
+  virtual void Rewind() = 0;
+
+  // Returns true if Next stopped because of a corrupt or truncated record
+  // rather than the end of the file.
+  virtual bool IsCorrupt() const = 0;
+
+  // Returns the size of the file in bytes.
+  virtual std::size_t GetSize() const = 0;
+};
+
+// Opens the record file at path.
+//
+// Returns nullptr if the file cannot be opened or mapped.
+std::unique_ptr<Reader> NewReader(const char* path);
+
+}  // namespace record
+}  // namespace mines
+
+#endif  // MINES_RECORD_READER_H_
@@ -0,0 +1,247 @@
+#include "mines/record/replay.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "mines/compat/make_unique.h"
+#include "mines/record/format.h"
+
+namespace mines {
+namespace record {
+
+namespace {
+
+// Returns true if two events are identical.
+bool SameEvent(const Event& a, const Event& b) {
+  return a.type == b.type && a.row == b.row && a.col == b.col &&
+         (a.type != Event::Type::UNCOVER ||
+          a.adjacent_mines == b.adjacent_mines);
+}
+
+// Returns a printable name for an event type.
+const char* EventTypeName(Event::Type type) {
+  switch (type) {
+    case Event::Type::UNCOVER:
+      return "UNCOVER";
+    case Event::Type::FLAG:
+      return "FLAG";
+    case Event::Type::UNFLAG:
+      return "UNFLAG";
+    case Event::Type::WIN:
+      return "WIN";
+    case Event::Type::LOSS:
+      return "LOSS";
+    case Event::Type::IDENTIFY_MINE:
+      return "IDENTIFY_MINE";
+    case Event::Type::IDENTIFY_BAD_FLAG:
+      return "IDENTIFY_BAD_FLAG";
+    case Event::Type::COVER:
+      return "COVER";
+    default:
+      return "?";
+  }
+}
+
+// Writes a one line description of an event.
+void PrintEvent(const char* label, const Event& event, std::FILE* out) {
+  std::fprintf(out, "  %s %s (%zu, %zu)", label, EventTypeName(event.type),
+               event.row, event.col);
+  if (event.type == Event::Type::UNCOVER) {
+    std::fprintf(out, " adjacent_mines=%zu", event.adjacent_mines);
+  }
+  std::fprintf(out, "\n");
+}
+
+class ReplayerImpl : public Replayer, public EventSubscriber {
+ public:
+  ReplayerImpl(const Record& record, const ReplayOptions& options,
+               std::unique_ptr<Game> game, std::vector<Action> actions)
+      : record_(record),
+        options_(options),
+        game_(std::move(game)),
+        actions_(std::move(actions)) {
+    game_->Subscribe(this);
+    snapshots_.push_back(game_->Snapshot());
+  }
+
+  ~ReplayerImpl() final = default;
+
+  bool Step() final {
+    if (position_ == actions_.size()) {
+      return false;
+    }
+    game_->Execute(actions_[position_]);
+    ++position_;
+
+    const std::size_t interval = options_.snapshot_interval;
+    if (interval > 0 && position_ % interval == 0 &&
+        position_ / interval == snapshots_.size()) {
+      snapshots_.push_back(game_->Snapshot());
+    }
+    return true;
+  }
+
+  void Run() final {
+    while (Step()) {
+    }
+  }
+
+  void Seek(std::size_t position) final {
+    position = std::min(position, actions_.size());
+
+    // Restore the nearest snapshot at or before the target, unless the current
+    // position is already closer.
+    const std::size_t interval = options_.snapshot_interval;
+    const std::size_t slot =
+        std::min(interval > 0 ? position / interval : 0, snapshots_.size() - 1);
+    const std::size_t snapshot_position = slot * interval;
+    if (position < position_ || snapshot_position > position_) {
+      game_->Restore(*snapshots_[slot]);
+      position_ = snapshot_position;
+    }
+
+    while (position_ < position) {
+      Step();
+    }
+  }
+
+  std::size_t GetPosition() const final { return position_; }
+
+  std::size_t GetActionCount() const final { return actions_.size(); }
+
+  const Action& GetNextAction() const final { return actions_[position_]; }
+
+  const Game& GetGame() const final { return *game_; }
+
+  bool Verify(Divergence* divergence) final {
+    Seek(0);
+    verifying_ = true;
+    diverged_ = false;
+    expected_events_ = record_.Events();
+    event_index_ = 0;
+
+    while (!diverged_ && Step()) {
+    }
+    verifying_ = false;
+
+    Event expected;
+    if (!diverged_ && HasEvents() && expected_events_.Next(expected)) {
+      Diverge(Divergence::Type::MISSING_EVENT);
+      divergence_.expected = expected;
+    }
+    if (!diverged_ && game_->GetState() != record_.header.state) {
+      Diverge(Divergence::Type::FINAL_STATE);
+    }
+
+    if (diverged_ && divergence != nullptr) {
+      *divergence = divergence_;
+    }
+    return !diverged_;
+  }
+
+  void NotifyEvent(const Event& event) final {
+    if (!verifying_ || diverged_ || !HasEvents()) {
+      return;
+    }
+    Event expected;
+    if (!expected_events_.Next(expected)) {
+      Diverge(Divergence::Type::EXTRA_EVENT);
+      divergence_.actual = event;
+    } else if (!SameEvent(event, expected)) {
+      Diverge(Divergence::Type::MISMATCH);
+      divergence_.expected = expected;
+      divergence_.actual = event;
+    }
+    ++event_index_;
+  }
+
+ private:
+  // Returns true if the record includes an event stream.
+  bool HasEvents() const { return (record_.header.flags & kHasEvents) != 0; }
+
+  // Records the start of a divergence at the current position.
+  void Diverge(Divergence::Type type) {
+    diverged_ = true;
+    divergence_ = Divergence();
+    divergence_.type = type;
+    // The position has not yet been advanced past the executing action.
+    divergence_.action = position_;
+    divergence_.event = event_index_;
+  }
+
+  const Record record_;
+  const ReplayOptions options_;
+  const std::unique_ptr<Game> game_;
+  const std::vector<Action> actions_;
+  std::size_t position_ = 0;
+
+  // snapshots_[i] is the state after i * snapshot_interval actions.
+  std::vector<std::unique_ptr<GameSnapshot>> snapshots_;
+
+  // State used by Verify.
+  bool verifying_ = false;
+  bool diverged_ = false;
+  EventDecoder expected_events_;
+  std::size_t event_index_ = 0;
+  Divergence divergence_;
+};
+
+}  // namespace
+
+void PrintDivergence(const Divergence& divergence, std::FILE* out) {
+  switch (divergence.type) {
+    case Divergence::Type::MISMATCH:
+      std::fprintf(out, "event %zu of action %zu differs:\n",
+                   divergence.event, divergence.action);
+      PrintEvent("recorded", divergence.expected, out);
+      PrintEvent("replayed", divergence.actual, out);
+      break;
+    case Divergence::Type::EXTRA_EVENT:
+      std::fprintf(out, "event %zu of action %zu was not recorded:\n",
+                   divergence.event, divergence.action);
+      PrintEvent("replayed", divergence.actual, out);
+      break;
+    case Divergence::Type::MISSING_EVENT:
+      std::fprintf(out, "event %zu was recorded but not replayed:\n",
+                   divergence.event);
+      PrintEvent("recorded", divergence.expected, out);
+      break;
+    case Divergence::Type::FINAL_STATE:
+      std::fprintf(out, "final game state differs after %zu actions\n",
+                   divergence.action);
+      break;
+  }
+}
+
+std::unique_ptr<Replayer> NewReplayer(const Record& record,
+                                      const ReplayOptions& options) {
+  const Header& header = record.header;
+  if (header.generator != kMineGeneratorId) {
+    return nullptr;
+  }
+  std::unique_ptr<Game> game =
+      NewGame(header.rows, header.cols, header.mines, header.seed);
+  if (game == nullptr) {
+    return nullptr;
+  }
+
+  std::vector<Action> actions;
+  actions.reserve(header.action_count);
+  ActionDecoder decoder = record.Actions();
+  Action action;
+  while (decoder.Next(action)) {
+    if (action.row >= header.rows) {
+      return nullptr;
+    }
+    actions.push_back(action);
+  }
+  if (actions.size() != header.action_count) {
+    return nullptr;
+  }
+
+  return MakeUnique<ReplayerImpl>(record, options, std::move(game),
+                                  std::move(actions));
+}
+
+}  // namespace record
+}  // namespace mines
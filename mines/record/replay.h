@@ -0,0 +1,115 @@
+#ifndef MINES_RECORD_REPLAY_H_
+#define MINES_RECORD_REPLAY_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "mines/game/game.h"
+#include "mines/record/reader.h"
+
+namespace mines {
+namespace record {
+
+// Options controlling a Replayer.
+struct ReplayOptions {
+  // A snapshot of the game is kept every snapshot_interval actions so that
+  // Seek only needs to re-execute the actions since the nearest snapshot.
+  // Zero disables snapshots other than the initial state.
+  std::size_t snapshot_interval = 256;
+};
+
+// Describes the first point at which a replayed game differs from its
+// record.
+struct Divergence {
+  enum class Type {
+    // The game generated a different event than the one recorded.
+    MISMATCH,
+
+    // The game generated an event after the recorded events ran out.
+    EXTRA_EVENT,
+
+    // The game generated fewer events than were recorded.
+    MISSING_EVENT,
+
+    // The events matched but the final game state did not.
+    FINAL_STATE,
+  };
+
+  Type type;
+
+  // The index of the action being executed when the games diverged. For
+  // MISSING_EVENT and FINAL_STATE this is the number of actions.
+  std::size_t action;
+
+  // The index of the event at which the games diverged.
+  std::size_t event;
+
+  // The recorded event. Not set for EXTRA_EVENT or FINAL_STATE.
+  Event expected;
+
+  // The generated event. Not set for MISSING_EVENT or FINAL_STATE.
+  Event actual;
+};
+
+// Writes a human readable description of a divergence.
+void PrintDivergence(const Divergence& divergence, std::FILE* out);
+
+// Re-executes the actions of a record against a freshly generated game.
+//
+// No solver or other subscriber is involved, so replay runs as fast as the
+// game can execute actions.
+class Replayer {
+ public:
+  virtual ~Replayer() = default;
+
+  // Executes the next action.
+  //
+  // Returns false if all actions have been executed.
+  virtual bool Step() = 0;
+
+  // Executes all remaining actions.
+  virtual void Run() = 0;
+
+  // Moves to the state of the game after the first position actions, going
+  // backwards if necessary. Positions past the end are clamped to the number
+  // of actions.
+  virtual void Seek(std::size_t position) = 0;
+
+  // Returns the number of actions executed so far.
+  virtual std::size_t GetPosition() const = 0;
+
+  // Returns the number of actions in the record.
+  virtual std::size_t GetActionCount() const = 0;
+
+  // Returns the action that the next call to Step will execute. Only valid
+  // when GetPosition() < GetActionCount().
+  virtual const Action& GetNextAction() const = 0;
+
+  // Returns the game being replayed.
+  virtual const Game& GetGame() const = 0;
+
+  // Replays the whole record from the start, comparing the generated events
+  // with the recorded event stream.
+  //
+  // Returns true if they are identical. Otherwise returns false and, if
+  // divergence is not null, describes the first difference. Replay stops at
+  // the action that diverged. Records without an event stream only have their
+  // final state checked.
+  virtual bool Verify(Divergence* divergence) = 0;
+};
+
+// Creates a replayer for a record.
+//
+// The record must remain valid for the lifetime of the replayer.
+//
+// Returns nullptr if the record was made with a different mine generator, has
+// invalid game parameters or its action stream is corrupt.
+std::unique_ptr<Replayer> NewReplayer(
+    const Record& record, const ReplayOptions& options = ReplayOptions());
+
+}  // namespace record
+}  // namespace mines
+
+#endif  // MINES_RECORD_REPLAY_H_
@@ -0,0 +1,172 @@
+#include "mines/record/writer.h"
+
+#include <limits>
+
+#include "mines/compat/make_unique.h"
+#include "mines/record/format.h"
+
+namespace mines {
+namespace record {
+
+namespace {
+
+// Returns true if value can be stored in a 32-bit header field.
+bool FitsHeaderField(std::uint64_t value) {
+  return value <= std::numeric_limits<std::uint32_t>::max();
+}
+
+}  // namespace
+
+Writer::Writer(std::FILE* file, const WriterOptions& options)
+    : options_(options), file_(file) {
+  buffer_.reserve(options_.buffer_size);
+}
+
+Writer::~Writer() {
+  Flush();
+  std::fclose(file_);
+}
+
+void Writer::NotifyEventSubscription(Game* game) {
+  FinishRecord();
+
+  // A game from another generator would be rebuilt wrongly on replay.
+  if (game->GetMineGenerator() != kMineGeneratorId ||
+      !FitsHeaderField(game->GetRows()) || !FitsHeaderField(game->GetCols()) ||
+      !FitsHeaderField(game->GetMines())) {
+    error_ = true;
+    return;
+  }
+  recording_ = true;
+  rows_ = static_cast<std::uint32_t>(game->GetRows());
+  cols_ = static_cast<std::uint32_t>(game->GetCols());
+  mines_ = static_cast<std::uint32_t>(game->GetMines());
+  seed_ = game->GetSeed();
+  state_ = game->GetState();
+}
+
+void Writer::NotifyAction(const Action& action) {
+  if (!recording_) {
+    return;
+  }
+  const std::uint64_t index =
+      static_cast<std::uint64_t>(action.row) * cols_ + action.col;
+  const std::int64_t delta =
+      static_cast<std::int64_t>(index - last_action_index_);
+  PutVarint(actions_, ZigZagEncode(delta) << 2 |
+                          static_cast<std::uint64_t>(action.type));
+  last_action_index_ = index;
+  ++action_count_;
+
+  if (state_ == Game::State::NEW) {
+    state_ = Game::State::PLAYING;
+  }
+}
+
+void Writer::NotifyEvent(const Event& event) {
+  if (!recording_) {
+    return;
+  }
+  switch (event.type) {
+    case Event::Type::WIN:
+      state_ = Game::State::WIN;
+      break;
+    case Event::Type::LOSS:
+      state_ = Game::State::LOSS;
+      break;
+    default:
+      break;
+  }
+  if (!options_.events) {
+    return;
+  }
+
+  const std::uint64_t index =
+      static_cast<std::uint64_t>(event.row) * cols_ + event.col;
+  const std::int64_t delta =
+      static_cast<std::int64_t>(index - last_event_index_);
+  PutVarint(events_, ZigZagEncode(delta) << 3 |
+                         static_cast<std::uint64_t>(event.type));
+  if (event.type == Event::Type::UNCOVER) {
+    events_.push_back(static_cast<std::uint8_t>(event.adjacent_mines));
+  }
+  last_event_index_ = index;
+  ++event_count_;
+}
+
+bool Writer::Flush() {
+  FinishRecord();
+  WriteBuffer();
+  if (std::fflush(file_) != 0) {
+    error_ = true;
+  }
+  return !error_;
+}
+
+void Writer::FinishRecord() {
+  if (!recording_) {
+    return;
+  }
+  recording_ = false;
+
+  if (!FitsHeaderField(action_count_) || !FitsHeaderField(event_count_) ||
+      !FitsHeaderField(actions_.size()) || !FitsHeaderField(events_.size())) {
+    error_ = true;
+    ClearRecord();
+    return;
+  }
+
+  PutFixed32(buffer_, kMagic);
+  PutFixed16(buffer_, kVersion);
+  PutFixed16(buffer_, kMineGeneratorId);
+  PutFixed32(buffer_, rows_);
+  PutFixed32(buffer_, cols_);
+  PutFixed32(buffer_, mines_);
+  PutFixed32(buffer_, seed_);
+  buffer_.push_back(options_.events ? kHasEvents : 0);
+  buffer_.push_back(static_cast<std::uint8_t>(state_));
+  PutFixed16(buffer_, 0);
+  PutFixed32(buffer_, static_cast<std::uint32_t>(action_count_));
+  PutFixed32(buffer_, static_cast<std::uint32_t>(event_count_));
+  PutFixed32(buffer_, static_cast<std::uint32_t>(actions_.size()));
+  PutFixed32(buffer_, static_cast<std::uint32_t>(events_.size()));
+  buffer_.insert(buffer_.end(), actions_.begin(), actions_.end());
+  buffer_.insert(buffer_.end(), events_.begin(), events_.end());
+  ClearRecord();
+  ++record_count_;
+
+  if (buffer_.size() >= options_.buffer_size) {
+    WriteBuffer();
+  }
+}
+
+void Writer::ClearRecord() {
+  actions_.clear();
+  events_.clear();
+  action_count_ = 0;
+  event_count_ = 0;
+  last_action_index_ = 0;
+  last_event_index_ = 0;
+}
+
+void Writer::WriteBuffer() {
+  if (!buffer_.empty() && std::fwrite(buffer_.data(), 1, buffer_.size(),
+                                      file_) != buffer_.size()) {
+    error_ = true;
+  }
+  buffer_.clear();
+}
+
+std::unique_ptr<Writer> NewWriter(const char* path,
+                                  const WriterOptions& options) {
+  std::FILE* file = std::fopen(path, "wb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+  // The Writer does its own buffering.
+  std::setvbuf(file, nullptr, _IONBF, 0);
+  return MakeUnique<Writer>(file, options);
+}
+
+}  // namespace record
+}  // namespace mines
@@ -0,0 +1,119 @@
+#ifndef MINES_RECORD_WRITER_H_
+#define MINES_RECORD_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "mines/game/game.h"
+
+namespace mines {
+namespace record {
+
+// Options controlling a Writer.
+struct WriterOptions {
+  // If true, the event stream is recorded along with the actions.
+  bool events = true;
+
+  // The number of bytes buffered before they are written to the file.
+  std::size_t buffer_size = 1 << 20;
+};
+
+// Writes a record of each game it is subscribed to.
+//
+// A single Writer may be subscribed to a series of games. The record of a game
+// is completed when the Writer is subscribed to the next game, or when Flush
+// is called or the Writer is destroyed. Completed records are buffered and
+// written to the file in large blocks.
+//
+// Game::Undo is not an action, so a game in which it is used cannot be
+// reproduced from its record.
+//
+// The header stores the dimensions, the number of mines and the size of each
+// stream in 32 bits. A game for which any of these is larger is not recorded,
+// and Flush reports an error. Neither is a game whose mines were not placed by
+// NewGame (see Game::GetMineGenerator), since replay could not rebuild it.
+//
+// See mines/record/format.h for a description of the format.
+class Writer : public EventSubscriber {
+ public:
+  // Creates a writer that takes ownership of the provided file.
+  Writer(std::FILE* file, const WriterOptions& options);
+
+  // Completes the current record and closes the file.
+  ~Writer() final;
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  // Begins a record of the new game, completing the previous record.
+  void NotifyEventSubscription(Game* game) final;
+
+  // Appends the action to the current record.
+  void NotifyAction(const Action& action) final;
+
+  // Appends the event to the current record if events are being recorded.
+  void NotifyEvent(const Event& event) final;
+
+  // Completes the current record and writes all buffered data to the file.
+  //
+  // Subsequent actions and events are ignored until the Writer is subscribed
+  // to another game.
+  //
+  // Returns false if an error occurred writing to the file.
+  bool Flush();
+
+  // Returns the number of records completed.
+  std::size_t GetRecordCount() const { return record_count_; }
+
+ private:
+  // Appends the current record to the output buffer, if there is one.
+  void FinishRecord();
+
+  // Discards the streams of the current record.
+  void ClearRecord();
+
+  // Writes the output buffer to the file.
+  void WriteBuffer();
+
+  const WriterOptions options_;
+  std::FILE* file_;
+  bool error_ = false;
+
+  // True if a game is being recorded.
+  bool recording_ = false;
+
+  // The header of the current record. The counts and sizes are filled in when
+  // the record is completed.
+  std::uint32_t rows_ = 0;
+  std::uint32_t cols_ = 0;
+  std::uint32_t mines_ = 0;
+  std::uint32_t seed_ = 0;
+  Game::State state_ = Game::State::NEW;
+
+  // The encoded streams of the current record.
+  std::vector<std::uint8_t> actions_;
+  std::vector<std::uint8_t> events_;
+  std::size_t action_count_ = 0;
+  std::size_t event_count_ = 0;
+  std::uint64_t last_action_index_ = 0;
+  std::uint64_t last_event_index_ = 0;
+
+  // Completed records waiting to be written to the file.
+  std::vector<std::uint8_t> buffer_;
+
+  std::size_t record_count_ = 0;
+};
+
+// Creates a Writer for the file at path, replacing any existing file.
+//
+// Returns nullptr if the file cannot be opened.
+std::unique_ptr<Writer> NewWriter(
+    const char* path, const WriterOptions& options = WriterOptions());
+
+}  // namespace record
+}  // namespace mines
+
+#endif  // MINES_RECORD_WRITER_H_
@@ -0,0 +1,88 @@
+// Verifies that recorded games replay identically.
+//
+// Usage:
+//   mines-replay [--quiet] FILE...
+//
+// Every record in each file is replayed against a freshly generated game and
+// the generated events are compared with the recorded ones. The first
+// divergence of each record is printed. The exit status is non-zero if any
+// record diverged or could not be read.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "mines/record/reader.h"
+#include "mines/record/replay.h"
+
+namespace mines {
+namespace {
+
+// Totals across all files.
+struct Summary {
+  std::size_t records = 0;
+  std::size_t diverged = 0;
+  std::size_t unreadable = 0;
+};
+
+// Verifies every record in the file at path.
+void VerifyFile(const char* path, bool quiet, Summary& summary) {
+  std::unique_ptr<record::Reader> reader = record::NewReader(path);
+  if (reader == nullptr) {
+    std::fprintf(stderr, "%s: unable to open\n", path);
+    ++summary.unreadable;
+    return;
+  }
+
+  record::Record r;
+  for (std::size_t index = 0; reader->Next(r); ++index) {
+    ++summary.records;
+    std::unique_ptr<record::Replayer> replayer = record::NewReplayer(r);
+    if (replayer == nullptr) {
+      std::fprintf(stderr, "%s: record %zu cannot be replayed\n", path, index);
+      ++summary.unreadable;
+      continue;
+    }
+    record::Divergence divergence;
+    if (!replayer->Verify(&divergence)) {
+      ++summary.diverged;
+      if (!quiet) {
+        std::printf("%s: record %zu (%ux%u, %u mines, seed %u): ", path, index,
+                    r.header.rows, r.header.cols, r.header.mines,
+                    r.header.seed);
+        record::PrintDivergence(divergence, stdout);
+      }
+    }
+  }
+  if (reader->IsCorrupt()) {
+    std::fprintf(stderr, "%s: corrupt record after %zu records\n", path,
+                 summary.records);
+    ++summary.unreadable;
+  }
+}
+
+}  // namespace
+}  // namespace mines
+
+int main(int argc, char* argv[]) {
+  bool quiet = false;
+  int first_file = 1;
+  if (argc > 1 && std::strcmp(argv[1], "--quiet") == 0) {
+    quiet = true;
+    ++first_file;
+  }
+  if (first_file >= argc) {
+    std::fprintf(stderr, "usage: %s [--quiet] FILE...\n", argv[0]);
+    return 1;
+  }
+
+  mines::Summary summary;
+  for (int i = first_file; i < argc; ++i) {
+    mines::VerifyFile(argv[i], quiet, summary);
+  }
+  std::printf("records     %zu\n", summary.records);
+  std::printf("diverged    %zu\n", summary.diverged);
+  std::printf("unreadable  %zu\n", summary.unreadable);
+  return summary.diverged == 0 && summary.unreadable == 0 ? 0 : 1;
+}
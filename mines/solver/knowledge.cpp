@@ -0,0 +1,92 @@
+#include "mines/solver/knowledge.h"
+
+namespace mines {
+namespace solver {
+
+Knowledge::Knowledge(std::size_t rows, std::size_t cols, std::size_t mines)
+    : grid_(rows, cols), mines_(mines) {
+  grid_.ForEach([this](std::size_t row, std::size_t col, Cell& cell) {
+    cell.adjacent_unknown = static_cast<std::uint8_t>(grid_.ForEachAdjacent(
+        row, col, [](std::size_t, std::size_t) { return true; }));
+  });
+}
+
+void Knowledge::Apply(const Event& event) {
+  if (!grid_.IsValid(event.row, event.col)) {
+    return;
+  }
+  ++version_;
+  Cell& cell = grid_(event.row, event.col);
+  cell.pending = false;
+  switch (event.type) {
+    case Event::Type::UNCOVER:
+      cell.state = CellState::UNCOVERED;
+      cell.adjacent_mines = static_cast<std::uint8_t>(event.adjacent_mines);
+      UpdateAdjacentUnknown(event.row, event.col, -1);
+      break;
+    case Event::Type::FLAG:
+      if (cell.state == CellState::BAD_FLAG) {
+        // Undo of a loss: the cell was flagged all along.
+        cell.state = CellState::FLAGGED;
+        break;
+      }
+      cell.state = CellState::FLAGGED;
+      ++flags_;
+      UpdateAdjacentUnknown(event.row, event.col, -1);
+      UpdateAdjacentFlags(event.row, event.col, 1);
+      break;
+    case Event::Type::UNFLAG:
+      cell.state = CellState::COVERED;
+      --flags_;
+      UpdateAdjacentUnknown(event.row, event.col, 1);
+      UpdateAdjacentFlags(event.row, event.col, -1);
+      break;
+    case Event::Type::WIN:
+      game_over_ = true;
+      break;
+    case Event::Type::LOSS:
+      cell.state = CellState::LOSING_MINE;
+      game_over_ = true;
+      break;
+    case Event::Type::IDENTIFY_MINE:
+      cell.state = CellState::MINE;
+      break;
+    case Event::Type::IDENTIFY_BAD_FLAG:
+      cell.state = CellState::BAD_FLAG;
+      break;
+    case Event::Type::COVER:
+      // Undo: whatever ended the game (if anything) has been retracted.
+      if (cell.state == CellState::UNCOVERED) {
+        UpdateAdjacentUnknown(event.row, event.col, 1);
+      }
+      cell.state = CellState::COVERED;
+      game_over_ = false;
+      break;
+  }
+}
+
+void Knowledge::UpdateAdjacentUnknown(std::size_t row, std::size_t col,
+                                      int delta) {
+  grid_.ForEachAdjacent(row, col,
+                        [this, delta](std::size_t row, std::size_t col) {
+                          Cell& cell = grid_(row, col);
+                          cell.adjacent_unknown =
+                              static_cast<std::uint8_t>(
+                                  cell.adjacent_unknown + delta);
+                          return false;
+                        });
+}
+
+void Knowledge::UpdateAdjacentFlags(std::size_t row, std::size_t col,
+                                    int delta) {
+  grid_.ForEachAdjacent(row, col,
+                        [this, delta](std::size_t row, std::size_t col) {
+                          Cell& cell = grid_(row, col);
+                          cell.adjacent_flags = static_cast<std::uint8_t>(
+                              cell.adjacent_flags + delta);
+                          return false;
+                        });
+}
+
+}  // namespace solver
+}  // namespace mines
@@ -0,0 +1,110 @@
+#ifndef MINES_SOLVER_KNOWLEDGE_H_
+#define MINES_SOLVER_KNOWLEDGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mines/game/game.h"
+#include "mines/game/grid.h"
+
+namespace mines {
+namespace solver {
+
+// What a solver knows about a game, built up from the game's events.
+//
+// Each event updates the cell it names and the counts kept by the cell's
+// neighbors, so applying an event takes constant time. Several strategies can
+// share one Knowledge rather than each maintaining its own copy.
+class Knowledge {
+ public:
+  // The knowledge about a single cell.
+  //
+  // None of the counts can exceed 8, so each is stored in a single byte to
+  // keep the grid compact on very large boards.
+  struct Cell {
+    CellState state = CellState::COVERED;
+
+    // The number of adjacent mines.
+    // Only valid if the state is UNCOVERED.
+    std::uint8_t adjacent_mines = 0;
+
+    // The number of adjacent cells that are flagged.
+    std::uint8_t adjacent_flags = 0;
+
+    // The number of adjacent cells that are covered and not flagged.
+    std::uint8_t adjacent_unknown = 0;
+
+    // True if an action on this cell has been recommended but no event for
+    // the cell has been received since.
+    bool pending = false;
+  };
+
+  // Creates the knowledge for a new game with the specified dimensions.
+  Knowledge(std::size_t rows, std::size_t cols, std::size_t mines);
+
+  // Updates the knowledge based on the event.
+  void Apply(const Event& event);
+
+  // Marks a cell as having an action recommended.
+  void SetPending(std::size_t row, std::size_t col) {
+    grid_(row, col).pending = true;
+  }
+
+  // Returns the knowledge about the specified cell.
+  const Cell& operator()(std::size_t row, std::size_t col) const {
+    return grid_(row, col);
+  }
+
+  // Returns the grid of cells.
+  const Grid<Cell>& GetGrid() const { return grid_; }
+
+  std::size_t GetRows() const { return grid_.GetRows(); }
+  std::size_t GetCols() const { return grid_.GetCols(); }
+  std::size_t GetMines() const { return mines_; }
+
+  // Returns the linear index of a cell.
+  std::size_t GetIndex(std::size_t row, std::size_t col) const {
+    return row * grid_.GetCols() + col;
+  }
+
+  // Returns true if the cell is covered, not flagged, and has no action
+  // pending.
+  bool IsUnknown(std::size_t row, std::size_t col) const {
+    const Cell& cell = grid_(row, col);
+    return cell.state == CellState::COVERED && !cell.pending;
+  }
+
+  // Returns true if the cell is uncovered and still has covered neighbors that
+  // are not flagged, i.e. it constrains the location of some mines.
+  bool IsConstraint(std::size_t row, std::size_t col) const {
+    const Cell& cell = grid_(row, col);
+    return cell.state == CellState::UNCOVERED && cell.adjacent_unknown > 0;
+  }
+
+  // Returns the number of flags.
+  std::size_t GetFlags() const { return flags_; }
+
+  // Returns true if the game has been won or lost.
+  bool IsGameOver() const { return game_over_; }
+
+  // Returns a number that changes every time an event is applied.
+  std::uint64_t GetVersion() const { return version_; }
+
+ private:
+  // Adds delta to the adjacent_unknown count of the cell's neighbors.
+  void UpdateAdjacentUnknown(std::size_t row, std::size_t col, int delta);
+
+  // Adds delta to the adjacent_flags count of the cell's neighbors.
+  void UpdateAdjacentFlags(std::size_t row, std::size_t col, int delta);
+
+  Grid<Cell> grid_;
+  const std::size_t mines_;
+  std::size_t flags_ = 0;
+  bool game_over_ = false;
+  std::uint64_t version_ = 0;
+};
+
+}  // namespace solver
+}  // namespace mines
+
+#endif  // MINES_SOLVER_KNOWLEDGE_H_
@@ -1,12 +1,15 @@
 #include "mines/solver/local.h"
 
+#include <algorithm>
 #include <cstddef>
-#include <queue>
-#include <tuple>
+#include <cstdint>
 #include <vector>
 
 #include "mines/compat/make_unique.h"
 #include "mines/game/grid.h"
+#include "mines/game/instrumentation.h"
+#include "mines/game/tiled_grid.h"
+#include "mines/solver/work_queue.h"
 
 namespace mines {
 namespace solver {
@@ -14,83 +17,193 @@ namespace local {
 
 namespace {
 
-class LocalSolver : public Solver {
+// Represents the solver's knowledge about a cell, beyond what the player can
+// see of it (see PlayerCell).
+//
+// None of the counts can exceed 8, so each is stored in four bits to keep the
+// grid compact on very large boards. The counts start at zero, so that a
+// default constructed cell is correct for any cell that has not been touched.
+struct Cell {
+  Cell() : flag_pending(0), adjacent_flags(0), adjacent_uncovered(0) {}
+
+  // True if a FLAG action has been recommended for this cell but its FLAG
+  // event has not yet been received.
+  std::uint8_t flag_pending : 1;
+
+  // The number of adjacent cells that are flagged.
+  std::uint8_t adjacent_flags : 4;
+
+  // The number of adjacent cells that are uncovered.
+  std::uint8_t adjacent_uncovered : 4;
+};
+static_assert(sizeof(Cell) == 2, "LocalSolver cells should be 2 bytes");
+
+// The local solver implementation.
+//
+// The solver's knowledge is stored in a CellGrid, which is either a Grid or,
+// for boards too large to allocate up front, a TiledGrid. A cell that has never
+// been written describes a covered cell with no known neighbors, so nothing
+// needs to be initialized for the parts of the board not yet played.
+//
+// The state and number of each cell are read from a ViewGrid of the same kind.
+// This is either the game's player view or, if that cannot be shared, a copy
+// kept by the solver.
+template <class CellGrid, class ViewGrid>
+class LocalSolverImpl : public Solver {
  public:
-  LocalSolver(const Game& game) : grid_(game.GetRows(), game.GetCols()) {
-    grid_.ForEach([this](std::size_t row, std::size_t col, Cell& cell) {
-      cell.adjacent_covered = CountAdjacentCells(row, col);
-    });
-  }
+  // If shared_view is null the solver keeps its own view.
+  LocalSolverImpl(const Game& game, const Options& options,
+                  const ViewGrid* shared_view)
+      : options_(options),
+        grid_(game.GetRows(), game.GetCols()),
+        own_view_(shared_view == nullptr ? game.GetRows() : 0,
+                  shared_view == nullptr ? game.GetCols() : 0),
+        view_(shared_view == nullptr ? &own_view_ : shared_view),
+        aq_(grid_.GetIndexLimit(), options.prioritize
+                                       ? WorkQueue::Order::PRIORITY
+                                       : WorkQueue::Order::FIFO) {}
 
-  ~LocalSolver() final = default;
+  ~LocalSolverImpl() final = default;
 
   void NotifyEvent(const Event& event) final {
     if (!grid_.IsValid(event.row, event.col)) {
       return;
     }
+    // The view does not yet reflect the event.
+    const CellState previous_state = (*view_)(event.row, event.col).state;
     Cell& cell = grid_(event.row, event.col);
-    cell.adjacent_mines = event.adjacent_mines;
     switch (event.type) {
       case Event::Type::UNCOVER:
-        cell.state = CellState::UNCOVERED;
-        UpdateAdjacentCovered(event.row, event.col);
-        QueueAnalyze(event.row, event.col);
-        QueueAnalyzeAdjacent(event.row, event.col);
+        HandleUncover(event.row, event.col, event.adjacent_mines);
         break;
       case Event::Type::FLAG:
-        cell.state = CellState::FLAGGED;
+        if (previous_state == CellState::BAD_FLAG) {
+          // Undo of a loss: the cell was flagged all along.
+          break;
+        }
+        cell.flag_pending = false;
         UpdateAdjacentFlags(event.row, event.col, true);
         QueueAnalyzeAdjacent(event.row, event.col);
         break;
       case Event::Type::UNFLAG:
-        cell.state = CellState::COVERED;
+        cell.flag_pending = false;
         UpdateAdjacentFlags(event.row, event.col, false);
         QueueAnalyzeAdjacent(event.row, event.col);
         break;
-      case Event::Type::WIN:
-        // No new knowledge.
+      case Event::Type::COVER:
+        // Undo of an uncover, or of the mines identified by a loss. Whatever
+        // ended the game (if anything) has been retracted.
+        if (previous_state == CellState::UNCOVERED) {
+          UpdateAdjacentCovered(event.row, event.col, false);
+          QueueAnalyzeAdjacent(event.row, event.col);
+        }
+        game_over_ = false;
         break;
+      case Event::Type::WIN:
       case Event::Type::LOSS:
-        cell.state = CellState::LOSING_MINE;
+        game_over_ = true;
         break;
       case Event::Type::IDENTIFY_MINE:
-        cell.state = CellState::MINE;
-        break;
       case Event::Type::IDENTIFY_BAD_FLAG:
-        cell.state = CellState::BAD_FLAG;
+        // No new knowledge.
         break;
     }
+    if (view_ == &own_view_) {
+      UpdatePlayerCell(event, &own_view_(event.row, event.col));
+    }
+  }
+
+  void NotifyCascade(const Cascade& cascade) final {
+    const bool own_view = view_ == &own_view_;
+    cascade.ForEach([this, own_view](std::size_t row, std::size_t col,
+                                     std::size_t adjacent_mines) {
+      HandleUncover(row, col, adjacent_mines);
+      if (own_view) {
+        UpdatePlayerCell(Event{Event::Type::UNCOVER, row, col, adjacent_mines},
+                         &own_view_(row, col));
+      }
+    });
   }
 
-  std::vector<Action> Analyze() final {
-    std::vector<Action> actions;
-    while (!aq_.empty()) {
-      std::size_t row = std::get<0>(aq_.front());
-      std::size_t col = std::get<1>(aq_.front());
-      aq_.pop();
+  AnalyzeStatus Analyze(const AnalyzeBudget& budget,
+                        std::vector<Action>* actions) final {
+    MINES_INSTRUMENT(instrumentation::ScopedTimer timer(&counters_.analyze_ns));
+    MINES_INSTRUMENT(++counters_.analyze_calls);
 
-      actions = AnalyzeCell(row, col);
-      if (!actions.empty()) {
+    // There is nothing to do once the game is over. The queue is kept, in case
+    // the end of the game is undone.
+    if (game_over_) {
+      return AnalyzeStatus::COMPLETE;
+    }
+
+    // Each step analyzes one cell. The queue holds the remaining work, so
+    // stopping early loses nothing.
+    AnalyzeStatus status = AnalyzeStatus::COMPLETE;
+    const std::size_t initial_size = actions->size();
+    std::size_t steps = 0;
+    while (!aq_.Empty()) {
+      const std::size_t index = aq_.Pop();
+      const std::size_t row = grid_.GetRow(index);
+      const std::size_t col = grid_.GetCol(index);
+
+      std::vector<Action> cell_actions = AnalyzeCell(row, col);
+      actions->insert(actions->end(), cell_actions.begin(),
+                      cell_actions.end());
+      if (actions->size() != initial_size && !options_.fixpoint) {
+        break;
+      }
+      if (budget.Exhausted(++steps) && !aq_.Empty()) {
+        status = AnalyzeStatus::INCOMPLETE;
+        MINES_INSTRUMENT(++counters_.incomplete_analyses);
         break;
       }
     }
-    return actions;
+
+    MINES_INSTRUMENT(counters_.actions_produced +=
+                     actions->size() - initial_size);
+    return status;
   }
 
  private:
+  // Updates the knowledge of the cell's neighbors and queues analysis, when
+  // the cell is uncovered.
+  void HandleUncover(std::size_t row, std::size_t col,
+                     std::size_t adjacent_mines) {
+    UpdateAdjacentCovered(row, col, true);
+    if (adjacent_mines != 0) {
+      Push(row, col);
+    }
+    QueueAnalyzeAdjacent(row, col);
+  }
+
   // Counts the number of adjacent cells.
   std::size_t CountAdjacentCells(std::size_t row, std::size_t col) const {
-    return grid_.ForEachAdjacent(
-        row, col, [this](std::size_t row, std::size_t col) { return true; });
+    const std::size_t rows = 1 + (row > 0 ? 1 : 0) +
+                             (row + 1 < grid_.GetRows() ? 1 : 0);
+    const std::size_t cols = 1 + (col > 0 ? 1 : 0) +
+                             (col + 1 < grid_.GetCols() ? 1 : 0);
+    return rows * cols - 1;
   }
 
-  // Updates the adjacent cells to subtract one from their adjacent_covered
-  // count. This should be called in response to an UNCOVER event.
-  void UpdateAdjacentCovered(std::size_t row, std::size_t col) {
-    grid_.ForEachAdjacent(row, col, [this](std::size_t row, std::size_t col) {
-      --grid_(row, col).adjacent_covered;
-      return false;
-    });
+  // Returns the number of adjacent cells that are still covered.
+  std::size_t CountAdjacentCovered(std::size_t row, std::size_t col) const {
+    return CountAdjacentCells(row, col) - grid_(row, col).adjacent_uncovered;
+  }
+
+  // Updates the adjacent cells to add or subtract one from their
+  // adjacent_uncovered count. This should be called in response to an UNCOVER
+  // event, or a COVER event for an uncovered cell.
+  void UpdateAdjacentCovered(std::size_t row, std::size_t col, bool uncover) {
+    grid_.ForEachAdjacent(row, col,
+                          [this, uncover](std::size_t row, std::size_t col) {
+                            Cell& cell = grid_(row, col);
+                            if (uncover) {
+                              ++cell.adjacent_uncovered;
+                            } else {
+                              --cell.adjacent_uncovered;
+                            }
+                            return false;
+                          });
   }
 
   // Updates the adjacent cells to add or subtract one from their adjacent_flags
@@ -98,18 +211,31 @@ class LocalSolver : public Solver {
   void UpdateAdjacentFlags(std::size_t row, std::size_t col, bool flag) {
     grid_.ForEachAdjacent(row, col,
                           [this, flag](std::size_t row, std::size_t col) {
-                            grid_(row, col).adjacent_flags += flag ? 1 : -1;
+                            Cell& cell = grid_(row, col);
+                            if (flag) {
+                              ++cell.adjacent_flags;
+                            } else {
+                              --cell.adjacent_flags;
+                            }
                             return false;
                           });
   }
 
   // Flags adjacent cells that are covered.
-  std::vector<Action> FlagAdjacentCovered(std::size_t row,
-                                          std::size_t col) const {
+  //
+  // Cells for which a FLAG action has already been recommended, but whose FLAG
+  // event has not yet been received, are skipped. Otherwise two cells sharing
+  // a neighbor could both recommend flagging it, and the second FLAG action
+  // would toggle the flag back off.
+  std::vector<Action> FlagAdjacentCovered(std::size_t row, std::size_t col) {
     std::vector<Action> a;
     grid_.ForEachAdjacent(row, col,
                           [this, &a](std::size_t row, std::size_t col) {
-                            if (grid_(row, col).state == CellState::COVERED) {
+                            Cell& cell = grid_(row, col);
+                            if ((*view_)(row, col).state ==
+                                    CellState::COVERED &&
+                                !cell.flag_pending) {
+                              cell.flag_pending = true;
                               a.push_back(Action{Action::Type::FLAG, row, col});
                             }
                             return false;
@@ -117,13 +243,31 @@ class LocalSolver : public Solver {
     return a;
   }
 
-  // Queues a cell to be analyzed. Does nothing for cells that are covered or
-  // have no adjacent mines.
+  // Queues a cell to be analyzed. Does nothing for cells that are covered,
+  // have no adjacent mines, or are already in the queue.
   void QueueAnalyze(std::size_t row, std::size_t col) {
-    const Cell& cell = grid_(row, col);
-    if (cell.adjacent_mines != 0 && cell.state == CellState::UNCOVERED) {
-      aq_.push(std::make_tuple(row, col));
+    const PlayerCell& cell = (*view_)(row, col);
+    if (cell.adjacent_mines == 0 || cell.state != CellState::UNCOVERED) {
+      return;
+    }
+    Push(row, col);
+  }
+
+  // Queues a cell that is known to be worth analyzing.
+  void Push(std::size_t row, std::size_t col) {
+    if (!aq_.Push(grid_.GetIndex(row, col), GetPriority(row, col))) {
+      ++counters_.redundant_analyses_avoided;
     }
+    MINES_INSTRUMENT(counters_.queue_high_water =
+                         std::max(counters_.queue_high_water, aq_.Size()));
+  }
+
+  // Returns the analysis priority of a cell when the queue is ordered by
+  // priority. Cells with fewer covered neighbors of unknown state are more
+  // likely to produce actions, so they are analyzed first.
+  unsigned GetPriority(std::size_t row, std::size_t col) const {
+    const Cell& cell = grid_(row, col);
+    return 8 - (CountAdjacentCovered(row, col) - cell.adjacent_flags);
   }
 
   // Queues analysis of adjacent cells.
@@ -136,51 +280,53 @@ class LocalSolver : public Solver {
 
   // Analyzes a cell and returns a (possibly empty) set of actions to perform.
   std::vector<Action> AnalyzeCell(std::size_t row, std::size_t col) {
+    MINES_INSTRUMENT(++counters_.cells_analyzed);
     if (!grid_.IsValid(row, col)) {
       return std::vector<Action>();
     }
-    const Cell& cell = grid_(row, col);
+    const PlayerCell& cell = (*view_)(row, col);
 
     // We only analyze cells that are uncovered with at least one adjacent mine.
     if (cell.adjacent_mines == 0 || cell.state != CellState::UNCOVERED) {
       return std::vector<Action>();
     }
 
-    if (cell.adjacent_mines == cell.adjacent_flags) {
+    if (cell.adjacent_mines == grid_(row, col).adjacent_flags) {
       return std::vector<Action>{Action{Action::Type::CHORD, row, col}};
     }
-    if (cell.adjacent_mines == cell.adjacent_covered) {
+    if (cell.adjacent_mines == CountAdjacentCovered(row, col)) {
       return FlagAdjacentCovered(row, col);
     }
     return std::vector<Action>();
   }
 
-  // Represents the solver's knowledge about a cell.
-  struct Cell {
-    CellState state = CellState::COVERED;
+  const Options options_;
 
-    // The number of adjacent mines.
-    // Only valid if the state is UNCOVERED.
-    std::size_t adjacent_mines = 0;
+  CellGrid grid_;
 
-    // The number of adjacent cells that are flagged.
-    std::size_t adjacent_flags = 0;
+  // The solver's own view, which is empty if the game's view is shared.
+  ViewGrid own_view_;
 
-    // The number of adjacent cells that are still covered.
-    // Note: This number will be computed in in the constructor.
-    std::size_t adjacent_covered = 0;
-  };
+  // The view the solver reads, either own_view_ or the game's player view.
+  const ViewGrid* view_;
 
-  Grid<Cell> grid_;
+  // The queue of cells to analyze, by their index in grid_.
+  WorkQueue aq_;
 
-  // The queue of cells to analyze.
-  std::queue<std::tuple<std::size_t, std::size_t>> aq_;
+  // True if the game has been won or lost.
+  bool game_over_ = false;
 };
 
 }  // namespace
 
-std::unique_ptr<Solver> New(const Game& game) {
-  return MakeUnique<LocalSolver>(game);
+std::unique_ptr<Solver> New(const Game& game, const Options& options) {
+  if (game.GetRows() * game.GetCols() > kMaxDenseGridCells) {
+    return MakeUnique<
+        LocalSolverImpl<TiledGrid<Cell>, TiledGrid<PlayerCell>>>(
+        game, options, nullptr);
+  }
+  return MakeUnique<LocalSolverImpl<Grid<Cell>, Grid<PlayerCell>>>(
+      game, options, options.shared_view ? game.GetPlayerView() : nullptr);
 }
 
 }  // namespace local
@@ -1,6 +1,7 @@
 #ifndef MINES_SOLVER_LOCAL_H_
 #define MINES_SOLVER_LOCAL_H_
 
+#include <cstddef>
 #include <memory>
 
 #include "mines/game/game.h"
@@ -10,6 +11,24 @@ namespace mines {
 namespace solver {
 namespace local {
 
+// Options controlling the behavior of the local solver.
+struct Options {
+  // If true, Analyze drains the entire analysis queue and returns every action
+  // that can be deduced from the current knowledge, rather than returning as
+  // soon as a single cell produces actions.
+  bool fixpoint = false;
+
+  // If true, cells with the most known neighbors are analyzed first rather
+  // than in the order they were queued.
+  bool prioritize = false;
+
+  // If true, the state and number of each cell are read from the game's player
+  // view (see Game::GetPlayerView) rather than from a copy kept by the solver,
+  // which halves its memory. The solver must then be subscribed to the game
+  // that created it. Ignored if the game has no player view.
+  bool shared_view = false;
+};
+
 // Provides a solver that produces actions from local analysis of a cell and
 // its immediate neighbors.
 //
@@ -21,7 +40,8 @@ namespace local {
 //
 // This solver is useful for automating "obvious" actions, but will not find
 // solutions that require reasoning about two or more cells simultaneously.
-std::unique_ptr<Solver> New(const Game& game);
+std::unique_ptr<Solver> New(const Game& game,
+                            const Options& options = Options());
 
 }  // namespace local
 }  // namespace solver
@@ -19,7 +19,9 @@ class NopSolver : public Solver {
   // Does nothing.
   void NotifyEvent(const Event&) final {}
 
-  std::vector<Action> Analyze() final { return std::vector<Action>(); }
+  AnalyzeStatus Analyze(const AnalyzeBudget&, std::vector<Action>*) final {
+    return AnalyzeStatus::COMPLETE;
+  }
 };
 
 }  // namespace
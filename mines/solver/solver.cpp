@@ -1,26 +1,78 @@
 #include "mines/solver/solver.h"
 
+#include "mines/game/tiled_grid.h"
 #include "mines/solver/local.h"
 #include "mines/solver/nop.h"
+#include "mines/solver/tiered.h"
 
 namespace mines {
 namespace solver {
 
-std::unique_ptr<Solver> New(Algorithm alg, Game& game) {
+constexpr std::size_t AnalyzeBudget::kClockInterval;
+
+namespace {
+
+// Creates a new solver for the specified algorithm. If subscribed is true, the
+// solver will be subscribed to the game, so it may read the game's player view.
+std::unique_ptr<Solver> NewSolver(Algorithm alg, const Game& game,
+                                  bool subscribed) {
   std::unique_ptr<Solver> solver;
   switch (alg) {
     case Algorithm::NONE:
       solver = nop::New();
       break;
-    case Algorithm::LOCAL:
-      solver = local::New(game);
+    case Algorithm::LOCAL: {
+      local::Options options;
+      options.fixpoint = true;
+      options.shared_view = subscribed;
+      solver = local::New(game, options);
+      break;
+    }
+    case Algorithm::TIERED:
+      // The tiered solver keeps dense per-cell state.
+      if (game.GetRows() * game.GetCols() > kMaxDenseGridCells) {
+        return nullptr;
+      }
+      solver = tiered::New(game);
       break;
     default:
       return nullptr;
   }
-  game.Subscribe(solver.get());
   return solver;
 }
 
+}  // namespace
+
+std::unique_ptr<Solver> New(Algorithm alg, Game& game) {
+  std::unique_ptr<Solver> solver = NewSolver(alg, game, true);
+  if (solver != nullptr) {
+    game.Subscribe(solver.get());
+  }
+  return solver;
+}
+
+std::unique_ptr<Solver> NewUnsubscribed(Algorithm alg, const Game& game) {
+  return NewSolver(alg, game, false);
+}
+
+void PrintCounters(const SolverCounters& counters, std::FILE* out) {
+  std::fprintf(out, "solver.analyze_calls    %zu\n", counters.analyze_calls);
+  std::fprintf(out, "solver.cells_analyzed   %zu\n", counters.cells_analyzed);
+  std::fprintf(out, "solver.actions_produced %zu\n", counters.actions_produced);
+  std::fprintf(out, "solver.incomplete       %zu\n",
+               counters.incomplete_analyses);
+  std::fprintf(out, "solver.redundant_skips  %zu\n",
+               counters.redundant_analyses_avoided);
+  std::fprintf(out, "solver.queue_high_water %zu\n", counters.queue_high_water);
+  std::fprintf(out, "solver.analyze_ms       %.3f\n",
+               counters.analyze_ns / 1e6);
+  for (const SolverCounters::TierCounters& tier : counters.tiers) {
+    std::fprintf(out,
+                 "solver.tier.%-11s calls %zu hits %zu actions %zu ms %.3f\n",
+                 tier.name, tier.calls, tier.hits, tier.actions,
+                 tier.ns / 1e6);
+  }
+}
+
 }  // namespace solver
 }  // namespace mines
@@ -1,6 +1,10 @@
 #ifndef MINES_SOLVER_SOLVER_H_
 #define MINES_SOLVER_SOLVER_H_
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <memory>
 #include <vector>
 
@@ -16,27 +20,189 @@ enum class Algorithm {
 
   // Perform local analysis of cells and their immediate neighbors.
   LOCAL,
+
+  // Escalate through increasingly expensive strategies, ending with a guess,
+  // only when the cheaper ones make no progress.
+  TIERED,
+};
+
+// Counters describing the work done by a solver.
+//
+// Except for redundant_analyses_avoided, which costs one increment per skipped
+// push and is always maintained, these are only maintained when the program is
+// built with instrumentation enabled (see mines/game/instrumentation.h).
+// Otherwise they remain zero.
+struct SolverCounters {
+  // The work done by one tier of a tiered solver.
+  struct TierCounters {
+    // The name of the tier.
+    const char* name = "";
+
+    // The number of times the tier ran.
+    std::size_t calls = 0;
+
+    // The number of times the tier produced actions, ending the analysis.
+    std::size_t hits = 0;
+
+    // The number of actions produced by the tier.
+    std::size_t actions = 0;
+
+    // The total time spent in the tier, in nanoseconds.
+    std::uint64_t ns = 0;
+  };
+
+  // The number of calls to Analyze.
+  std::size_t analyze_calls = 0;
+
+  // The number of cells examined by Analyze.
+  std::size_t cells_analyzed = 0;
+
+  // The number of actions returned by Analyze.
+  std::size_t actions_produced = 0;
+
+  // The number of calls to Analyze that ran out of budget.
+  std::size_t incomplete_analyses = 0;
+
+  // The number of times a cell was not queued for analysis because it was
+  // already waiting in the queue.
+  std::size_t redundant_analyses_avoided = 0;
+
+  // The largest number of cells waiting for analysis at one time.
+  std::size_t queue_high_water = 0;
+
+  // The total time spent in Analyze, in nanoseconds.
+  std::uint64_t analyze_ns = 0;
+
+  // The work done by each tier of a tiered solver, cheapest first. Empty for
+  // other solvers.
+  std::vector<TierCounters> tiers;
+
+  // Accumulates the counters from another solver.
+  void Merge(const SolverCounters& other) {
+    analyze_calls += other.analyze_calls;
+    cells_analyzed += other.cells_analyzed;
+    actions_produced += other.actions_produced;
+    incomplete_analyses += other.incomplete_analyses;
+    redundant_analyses_avoided += other.redundant_analyses_avoided;
+    if (other.queue_high_water > queue_high_water) {
+      queue_high_water = other.queue_high_water;
+    }
+    analyze_ns += other.analyze_ns;
+    if (tiers.size() < other.tiers.size()) {
+      tiers.resize(other.tiers.size());
+    }
+    for (std::size_t i = 0; i < other.tiers.size(); ++i) {
+      tiers[i].name = other.tiers[i].name;
+      tiers[i].calls += other.tiers[i].calls;
+      tiers[i].hits += other.tiers[i].hits;
+      tiers[i].actions += other.tiers[i].actions;
+      tiers[i].ns += other.tiers[i].ns;
+    }
+  }
+};
+
+// Writes a human readable dump of the counters.
+void PrintCounters(const SolverCounters& counters, std::FILE* out);
+
+// Limits on the work done by a single call to Solver::Analyze.
+struct AnalyzeBudget {
+  using Clock = std::chrono::steady_clock;
+
+  // The clock is only read once every kClockInterval steps, which keeps the
+  // check cheap relative to a step.
+  static constexpr std::size_t kClockInterval = 64;
+
+  // Analyze returns soon after this time. The default is no deadline.
+  Clock::time_point deadline = Clock::time_point::max();
+
+  // Analyze returns after this many steps. What a step is depends on the
+  // algorithm. Zero means no limit.
+  std::size_t max_steps = 0;
+
+  // Returns a budget whose deadline is the specified duration from now.
+  static AnalyzeBudget For(Clock::duration duration) {
+    AnalyzeBudget budget;
+    budget.deadline = Clock::now() + duration;
+    return budget;
+  }
+
+  // Returns true if an analysis that has taken the specified number of steps
+  // should stop.
+  bool Exhausted(std::size_t steps) const {
+    if (max_steps != 0 && steps >= max_steps) {
+      return true;
+    }
+    return deadline != Clock::time_point::max() &&
+           steps % kClockInterval == 0 && Clock::now() >= deadline;
+  }
+};
+
+// The outcome of a budgeted call to Solver::Analyze.
+enum class AnalyzeStatus {
+  // The analysis finished. If no actions were produced, no progress can be
+  // made.
+  COMPLETE,
+
+  // The budget ran out first. The solver keeps its place, so calling Analyze
+  // again continues the analysis, even if no actions were produced.
+  INCOMPLETE,
 };
 
 class Solver : public EventSubscriber {
  public:
   virtual ~Solver() = default;
 
-  // Recommends actions based on the Solver's current knowledge of the game.
+  // Recommends actions based on the Solver's current knowledge of the game,
+  // appending them to actions.
   //
   // The Solver is NOT required to produce a complete set of actions, nor is it
   // required to be idempotent.
   //
-  // The Solver must return an empty vector to indicate that no progress can be
-  // made.
-  virtual std::vector<Action> Analyze() = 0;
+  // The analysis stops early if the budget runs out, returning the actions
+  // found so far. At least one step is always taken, so repeated calls make
+  // progress however small the budget.
+  //
+  // Once the game has been won or lost, no actions are recommended and the
+  // analysis is COMPLETE.
+  virtual AnalyzeStatus Analyze(const AnalyzeBudget& budget,
+                                std::vector<Action>* actions) = 0;
+
+  // Recommends actions without a budget.
+  //
+  // Returns an empty vector to indicate that no progress can be made.
+  std::vector<Action> Analyze() {
+    std::vector<Action> actions;
+    Analyze(AnalyzeBudget(), &actions);
+    return actions;
+  }
+
+  // Returns counters describing the work done by the solver.
+  const SolverCounters& GetCounters() const { return counters_; }
+
+ protected:
+  // Counters to be maintained by implementations.
+  SolverCounters counters_;
 };
 
 // Creates a new solver for the specified algorithm.
 //
 // This solver will be automatically subscribed to the provided game.
+//
+// Returns nullptr if the algorithm does not support the game's board. The
+// tiered solver keeps dense per-cell state, so it does not support boards
+// with more than kMaxDenseGridCells cells (see mines/game/tiled_grid.h).
 std::unique_ptr<Solver> New(Algorithm alg, Game& game);
 
+// Creates a new solver for the specified algorithm without subscribing it to
+// the game.
+//
+// The caller is responsible for passing the game's events to the solver. This
+// allows the solver to be used on a different thread than the game.
+//
+// Returns nullptr if the algorithm does not support the game's board, as for
+// New.
+std::unique_ptr<Solver> NewUnsubscribed(Algorithm alg, const Game& game);
+
 }  // namespace solver
 }  // namespace mines
 
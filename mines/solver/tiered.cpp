@@ -0,0 +1,968 @@
+#include "mines/solver/tiered.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mines/compat/make_unique.h"
+#include "mines/game/hash.h"
+#include "mines/game/instrumentation.h"
+#include "mines/solver/knowledge.h"
+#include "mines/solver/work_queue.h"
+
+namespace mines {
+namespace solver {
+namespace tiered {
+
+namespace {
+
+// A strategy used by the tiered solver.
+//
+// The tiers that work from a queue of cells count the cells they analyze in
+// the solver's counters.
+class Tier {
+ public:
+  Tier(Knowledge* knowledge, SolverCounters* counters)
+      : knowledge_(knowledge), counters_(counters) {}
+  virtual ~Tier() = default;
+
+  // Returns a short name for the tier, used in the counters.
+  virtual const char* GetName() const = 0;
+
+  // Called after the event has been applied to the shared knowledge.
+  virtual void NotifyEvent(const Event& event) {}
+
+  // Appends actions found by the tier to actions.
+  //
+  // steps is the number of steps taken so far by this call to the solver, and
+  // is advanced by the tier. Returns INCOMPLETE if the budget ran out first.
+  virtual AnalyzeStatus Analyze(const AnalyzeBudget& budget, std::size_t* steps,
+                                std::vector<Action>* actions) = 0;
+
+ protected:
+  // Appends an action for a cell and marks the cell as pending, so that no
+  // tier acts on it again before its event arrives.
+  void Recommend(Action::Type type, std::size_t row, std::size_t col,
+                 std::vector<Action>* actions) {
+    knowledge_->SetPending(row, col);
+    actions->push_back(Action{type, row, col});
+  }
+
+  // Returns the number of mines adjacent to a constraint that are not yet
+  // flagged.
+  int GetRemaining(std::size_t row, std::size_t col) const {
+    const Knowledge::Cell& cell = (*knowledge_)(row, col);
+    return static_cast<int>(cell.adjacent_mines) -
+           static_cast<int>(cell.adjacent_flags);
+  }
+
+  // Returns true if any neighbor of the cell has an action pending.
+  bool HasPendingNeighbor(std::size_t row, std::size_t col) const {
+    return knowledge_->GetGrid().ForEachAdjacent(
+               row, col, [this](std::size_t row, std::size_t col) {
+                 return (*knowledge_)(row, col).pending;
+               }) > 0;
+  }
+
+  // Queues the cell and its neighbors that are constraints.
+  void QueueConstraints(std::size_t row, std::size_t col, WorkQueue* queue) {
+    if (knowledge_->IsConstraint(row, col)) {
+      Push(row, col, queue);
+    }
+    knowledge_->GetGrid().ForEachAdjacent(
+        row, col, [this, queue](std::size_t row, std::size_t col) {
+          if (knowledge_->IsConstraint(row, col)) {
+            Push(row, col, queue);
+          }
+          return false;
+        });
+  }
+
+  // Removes the next cell from the queue, counting it as analyzed.
+  std::size_t Pop(WorkQueue* queue) {
+    MINES_INSTRUMENT(++counters_->cells_analyzed);
+    return queue->Pop();
+  }
+
+  Knowledge* const knowledge_;
+  SolverCounters* const counters_;
+
+ private:
+  // Queues a cell, counting it as avoided if it was already queued.
+  void Push(std::size_t row, std::size_t col, WorkQueue* queue) {
+    if (!queue->Push(knowledge_->GetIndex(row, col))) {
+      ++counters_->redundant_analyses_avoided;
+    }
+    MINES_INSTRUMENT(counters_->queue_high_water =
+                         std::max(counters_->queue_high_water, queue->Size()));
+  }
+};
+
+// Applies the local rules to the cells around each event.
+class LocalTier : public Tier {
+ public:
+  LocalTier(Knowledge* knowledge, SolverCounters* counters)
+      : Tier(knowledge, counters),
+        queue_(knowledge->GetRows() * knowledge->GetCols()) {}
+
+  const char* GetName() const final { return "local"; }
+
+  void NotifyEvent(const Event& event) final {
+    QueueConstraints(event.row, event.col, &queue_);
+  }
+
+  // Each step applies the rules to one cell.
+  AnalyzeStatus Analyze(const AnalyzeBudget& budget, std::size_t* steps,
+                        std::vector<Action>* actions) final {
+    const std::size_t initial_size = actions->size();
+    while (!queue_.Empty()) {
+      const std::size_t index = Pop(&queue_);
+      AnalyzeCell(index / knowledge_->GetCols(), index % knowledge_->GetCols(),
+                  actions);
+      if (actions->size() != initial_size) {
+        break;
+      }
+      if (budget.Exhausted(++*steps) && !queue_.Empty()) {
+        return AnalyzeStatus::INCOMPLETE;
+      }
+    }
+    return AnalyzeStatus::COMPLETE;
+  }
+
+ private:
+  // Uncovers the neighbors of a cell if all of its mines are flagged, or flags
+  // them if they must all be mines.
+  void AnalyzeCell(std::size_t row, std::size_t col,
+                   std::vector<Action>* actions) {
+    if (!knowledge_->IsConstraint(row, col)) {
+      return;
+    }
+    const int remaining = GetRemaining(row, col);
+    Action::Type type;
+    if (remaining == 0) {
+      type = Action::Type::UNCOVER;
+    } else if (remaining == (*knowledge_)(row, col).adjacent_unknown) {
+      type = Action::Type::FLAG;
+    } else {
+      return;
+    }
+    knowledge_->GetGrid().ForEachAdjacent(
+        row, col, [this, type, actions](std::size_t row, std::size_t col) {
+          if (knowledge_->IsUnknown(row, col)) {
+            Recommend(type, row, col, actions);
+          }
+          return false;
+        });
+  }
+
+  // The cells whose surroundings have changed since they were last analyzed.
+  WorkQueue queue_;
+};
+
+// Compares pairs of nearby constraints.
+//
+// If constraints A and B have unflagged mine counts rA and rB, and B can see
+// n unknown cells that A cannot, then rB - rA == n means that every one of
+// those n cells is a mine, and that every unknown cell only A can see is safe.
+class SubsetTier : public Tier {
+ public:
+  SubsetTier(Knowledge* knowledge, SolverCounters* counters)
+      : Tier(knowledge, counters),
+        queue_(knowledge->GetRows() * knowledge->GetCols()) {}
+
+  const char* GetName() const final { return "subset"; }
+
+  void NotifyEvent(const Event& event) final {
+    QueueConstraints(event.row, event.col, &queue_);
+  }
+
+  // Each step pairs one constraint with every constraint within two cells.
+  AnalyzeStatus Analyze(const AnalyzeBudget& budget, std::size_t* steps,
+                        std::vector<Action>* actions) final {
+    const std::size_t initial_size = actions->size();
+    while (!queue_.Empty()) {
+      const std::size_t index = Pop(&queue_);
+      AnalyzePairs(index / knowledge_->GetCols(),
+                   index % knowledge_->GetCols(), actions);
+      if (actions->size() != initial_size) {
+        break;
+      }
+      if (budget.Exhausted(++*steps) && !queue_.Empty()) {
+        return AnalyzeStatus::INCOMPLETE;
+      }
+    }
+    return AnalyzeStatus::COMPLETE;
+  }
+
+ private:
+  // Sets of cells are kept as masks over the 7x7 window centered on the
+  // constraint being analyzed, which holds the neighbors of every constraint
+  // it is paired with.
+  static constexpr int kWindow = 7;
+  static constexpr int kRadius = kWindow / 2;
+
+  // Returns true if the cell is a constraint whose neighbors have no actions
+  // pending, so that its unknown neighbors and remaining mines agree.
+  bool IsUsable(std::size_t row, std::size_t col) const {
+    return knowledge_->IsConstraint(row, col) && !HasPendingNeighbor(row, col);
+  }
+
+  // Returns the unknown neighbors of a cell as a mask over the window centered
+  // on (center_row, center_col).
+  std::uint64_t GetUnknownMask(std::size_t center_row, std::size_t center_col,
+                               std::size_t row, std::size_t col) const {
+    std::uint64_t mask = 0;
+    knowledge_->GetGrid().ForEachAdjacent(
+        row, col, [&](std::size_t row, std::size_t col) {
+          if (knowledge_->IsUnknown(row, col)) {
+            const int dr = static_cast<int>(row - center_row) + kRadius;
+            const int dc = static_cast<int>(col - center_col) + kRadius;
+            mask |= std::uint64_t{1} << (dr * kWindow + dc);
+          }
+          return false;
+        });
+    return mask;
+  }
+
+  // Recommends an action for each cell in a mask over the window centered on
+  // (center_row, center_col).
+  void RecommendMask(Action::Type type, std::uint64_t mask,
+                     std::size_t center_row, std::size_t center_col,
+                     std::vector<Action>* actions) {
+    for (int bit = 0; mask != 0; ++bit, mask >>= 1) {
+      if ((mask & 1) != 0) {
+        Recommend(type, center_row + bit / kWindow - kRadius,
+                  center_col + bit % kWindow - kRadius, actions);
+      }
+    }
+  }
+
+  // Pairs the constraint with each constraint within two cells, stopping at
+  // the first pair that produces actions.
+  void AnalyzePairs(std::size_t row, std::size_t col,
+                    std::vector<Action>* actions) {
+    if (!IsUsable(row, col)) {
+      return;
+    }
+    const std::uint64_t a = GetUnknownMask(row, col, row, col);
+    const int remaining_a = GetRemaining(row, col);
+    const std::size_t row_end = std::min(row + 3, knowledge_->GetRows());
+    const std::size_t col_end = std::min(col + 3, knowledge_->GetCols());
+    for (std::size_t r = row < 2 ? 0 : row - 2; r < row_end; ++r) {
+      for (std::size_t c = col < 2 ? 0 : col - 2; c < col_end; ++c) {
+        if ((r == row && c == col) || !IsUsable(r, c)) {
+          continue;
+        }
+        const std::uint64_t b = GetUnknownMask(row, col, r, c);
+        if ((a & b) == 0) {
+          continue;
+        }
+        const std::uint64_t only_a = a & ~b;
+        const std::uint64_t only_b = b & ~a;
+        const int remaining_b = GetRemaining(r, c);
+        const int count_a = static_cast<int>(std::bitset<64>(only_a).count());
+        const int count_b = static_cast<int>(std::bitset<64>(only_b).count());
+        std::uint64_t mines = 0;
+        std::uint64_t safe = 0;
+        if (remaining_b - remaining_a == count_b) {
+          mines = only_b;
+          safe = only_a;
+        } else if (remaining_a - remaining_b == count_a) {
+          mines = only_a;
+          safe = only_b;
+        }
+        if (mines != 0 || safe != 0) {
+          RecommendMask(Action::Type::FLAG, mines, row, col, actions);
+          RecommendMask(Action::Type::UNCOVER, safe, row, col, actions);
+          return;
+        }
+      }
+    }
+  }
+
+  // The constraints whose surroundings have changed since they were last
+  // analyzed.
+  WorkQueue queue_;
+};
+
+// Enumerates every mine layout consistent with the constraints.
+//
+// The unknown cells bordering constraints are split into components that
+// share no constraints, and each component is searched separately with
+// backtracking. A pass over every component is kept across calls that run out
+// of budget, and restarted whenever the knowledge changes.
+//
+// The layouts of a component are not equally likely. A layout with k mines
+// leaves the remaining mines to the unknown cells outside the component, which
+// can hold them in C(other cells, remaining mines - k) ways, so each layout is
+// weighted by that count when the probabilities are worked out.
+class ExactTier : public Tier {
+ public:
+  ExactTier(Knowledge* knowledge, SolverCounters* counters)
+      : Tier(knowledge, counters),
+        var_index_(knowledge->GetRows() * knowledge->GetCols(), -1),
+        probability_(var_index_.size(), -1.0f) {}
+
+  const char* GetName() const final { return "exact"; }
+
+  // Examining a cell while building a pass is one step, as is each node of
+  // the search.
+  AnalyzeStatus Analyze(const AnalyzeBudget& budget, std::size_t* steps,
+                        std::vector<Action>* actions) final {
+    if (!has_pass_ || pass_version_ != knowledge_->GetVersion()) {
+      if (!BuildPass(budget, steps)) {
+        return AnalyzeStatus::INCOMPLETE;
+      }
+    }
+    while (!IsPassComplete()) {
+      if (!Search(budget, steps)) {
+        return AnalyzeStatus::INCOMPLETE;
+      }
+      const std::size_t initial_size = actions->size();
+      FinishComponent(actions);
+      if (actions->size() != initial_size) {
+        break;
+      }
+    }
+    return AnalyzeStatus::COMPLETE;
+  }
+
+  // Returns true if every component has been searched since the knowledge last
+  // changed, in which case GetProbability is valid.
+  bool HasProbabilities() const {
+    return IsPassComplete() && pass_version_ == knowledge_->GetVersion();
+  }
+
+  // Returns the probability that the cell with the specified index is a mine,
+  // or a negative number if it is not known.
+  float GetProbability(std::size_t index) const { return probability_[index]; }
+
+ private:
+  // Components with more cells than this are not searched.
+  static constexpr std::size_t kMaxComponentVars = 64;
+
+  // A component is abandoned if its search visits more nodes than this.
+  static constexpr std::size_t kMaxNodes = std::size_t{1} << 22;
+
+  // An unknown cell bordering at least one constraint.
+  struct Var {
+    std::size_t index;
+    std::uint8_t constraint_count;
+    std::uint32_t constraints[8];
+
+    // 1 if the cell is assumed to be a mine, 0 if safe, -1 if unassigned.
+    std::int8_t value;
+  };
+
+  // An uncovered cell with unknown neighbors.
+  struct Constraint {
+    // The number of mines among the unknown neighbors.
+    int remaining;
+
+    std::uint8_t var_count;
+    std::uint32_t vars[8];
+
+    // The number of neighbors assumed to be mines, and not yet assigned.
+    int mines;
+    int unassigned;
+  };
+
+  bool IsPassComplete() const {
+    return has_pass_ && component_ == component_begin_.size() - 1;
+  }
+
+  // Collects the constraints and their unknown neighbors, and orders the
+  // neighbors into components.
+  //
+  // Returns false if the budget ran out first. The next call continues from
+  // the same cell, unless the knowledge has changed in between.
+  bool BuildPass(const AnalyzeBudget& budget, std::size_t* steps) {
+    if (!building_ || build_version_ != knowledge_->GetVersion()) {
+      StartBuild();
+    }
+
+    const Grid<Knowledge::Cell>& grid = knowledge_->GetGrid();
+    for (; build_row_ < grid.GetRows(); ++build_row_, build_col_ = 0) {
+      for (; build_col_ < grid.GetCols(); ++build_col_) {
+        if (budget.Exhausted(++*steps)) {
+          return false;
+        }
+        const std::size_t row = build_row_;
+        const std::size_t col = build_col_;
+        if (knowledge_->IsUnknown(row, col)) {
+          ++unknown_cells_;
+        }
+        if (!knowledge_->IsConstraint(row, col) ||
+            HasPendingNeighbor(row, col)) {
+          continue;
+        }
+        const std::uint32_t c = static_cast<std::uint32_t>(constraints_.size());
+        constraints_.push_back(Constraint());
+        Constraint& constraint = constraints_.back();
+        constraint.remaining = GetRemaining(row, col);
+        constraint.var_count = 0;
+        constraint.mines = 0;
+        grid.ForEachAdjacent(
+            row, col, [this, c, &constraint](std::size_t row,
+                                             std::size_t col) {
+              if (knowledge_->IsUnknown(row, col)) {
+                const std::uint32_t v = GetVar(knowledge_->GetIndex(row, col));
+                Var& var = vars_[v];
+                var.constraints[var.constraint_count++] = c;
+                constraint.vars[constraint.var_count++] = v;
+              }
+              return false;
+            });
+        constraint.unassigned = constraint.var_count;
+      }
+    }
+
+    // Order the vars breadth first from each unvisited var, so that each
+    // component is contiguous and constraints are completed early in the
+    // search, where they prune the most.
+    order_.clear();
+    component_begin_.assign(1, 0);
+    std::vector<bool> visited(vars_.size(), false);
+    for (std::uint32_t start = 0; start < vars_.size(); ++start) {
+      if (visited[start]) {
+        continue;
+      }
+      visited[start] = true;
+      order_.push_back(start);
+      for (std::size_t i = component_begin_.back(); i < order_.size(); ++i) {
+        const Var& var = vars_[order_[i]];
+        for (std::size_t j = 0; j < var.constraint_count; ++j) {
+          const Constraint& constraint = constraints_[var.constraints[j]];
+          for (std::size_t k = 0; k < constraint.var_count; ++k) {
+            const std::uint32_t v = constraint.vars[k];
+            if (!visited[v]) {
+              visited[v] = true;
+              order_.push_back(v);
+            }
+          }
+        }
+      }
+      component_begin_.push_back(order_.size());
+    }
+
+    building_ = false;
+    has_pass_ = true;
+    pass_version_ = knowledge_->GetVersion();
+    component_ = 0;
+    StartComponent();
+    return true;
+  }
+
+  // Discards the previous pass and starts building a new one.
+  void StartBuild() {
+    // Only the cells of vars have an index or a probability to reset.
+    for (const Var& var : vars_) {
+      var_index_[var.index] = -1;
+      probability_[var.index] = -1.0f;
+    }
+    vars_.clear();
+    constraints_.clear();
+    unknown_cells_ = 0;
+
+    has_pass_ = false;
+    building_ = true;
+    build_version_ = knowledge_->GetVersion();
+    build_row_ = 0;
+    build_col_ = 0;
+  }
+
+  // Returns the var for the cell with the specified index, adding it if
+  // necessary.
+  std::uint32_t GetVar(std::size_t index) {
+    if (var_index_[index] < 0) {
+      var_index_[index] = static_cast<std::int32_t>(vars_.size());
+      vars_.push_back(Var{index, 0, {}, -1});
+    }
+    return static_cast<std::uint32_t>(var_index_[index]);
+  }
+
+  // Resets the search state for the current component.
+  void StartComponent() {
+    depth_ = 0;
+    nodes_ = 0;
+    solutions_ = 0;
+    assigned_mines_ = 0;
+    if (!IsPassComplete()) {
+      const std::size_t size = GetComponentSize();
+      if (size <= kMaxComponentVars) {
+        solutions_by_mines_.assign(size + 1, 0);
+        mine_counts_.assign(size * (size + 1), 0);
+      }
+    }
+  }
+
+  std::size_t GetComponentSize() const {
+    return component_begin_[component_ + 1] - component_begin_[component_];
+  }
+
+  Var& GetComponentVar(std::size_t i) {
+    return vars_[order_[component_begin_[component_] + i]];
+  }
+
+  // Assumes a value for a var, updating its constraints.
+  void Assign(Var& var, std::int8_t value) {
+    var.value = value;
+    assigned_mines_ += value;
+    for (std::size_t i = 0; i < var.constraint_count; ++i) {
+      Constraint& constraint = constraints_[var.constraints[i]];
+      constraint.mines += value;
+      --constraint.unassigned;
+    }
+  }
+
+  // Reverses Assign.
+  void Unassign(Var& var) {
+    assigned_mines_ -= var.value;
+    for (std::size_t i = 0; i < var.constraint_count; ++i) {
+      Constraint& constraint = constraints_[var.constraints[i]];
+      constraint.mines -= var.value;
+      ++constraint.unassigned;
+    }
+    var.value = -1;
+  }
+
+  // Moves a var to its next value: unassigned, safe, mine, then unassigned
+  // again. Returns false when the var's values are exhausted.
+  bool Advance(Var& var) {
+    const std::int8_t value = var.value;
+    if (value >= 0) {
+      Unassign(var);
+    }
+    if (value == 1) {
+      return false;
+    }
+    Assign(var, value + 1);
+    return true;
+  }
+
+  // Returns true if the var's constraints can still be satisfied.
+  bool IsConsistent(const Var& var) const {
+    if (assigned_mines_ > GetUnflaggedMines()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < var.constraint_count; ++i) {
+      const Constraint& constraint = constraints_[var.constraints[i]];
+      if (constraint.mines > constraint.remaining ||
+          constraint.mines + constraint.unassigned < constraint.remaining) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::ptrdiff_t GetUnflaggedMines() const {
+    return static_cast<std::ptrdiff_t>(knowledge_->GetMines()) -
+           static_cast<std::ptrdiff_t>(knowledge_->GetFlags());
+  }
+
+  // Continues the search of the current component. Returns false if the
+  // budget ran out before the search finished.
+  bool Search(const AnalyzeBudget& budget, std::size_t* steps) {
+    const std::size_t size = GetComponentSize();
+    if (size > kMaxComponentVars) {
+      solutions_ = 0;
+      return true;
+    }
+    for (;;) {
+      if (depth_ == size) {
+        const std::size_t mines = static_cast<std::size_t>(assigned_mines_);
+        ++solutions_;
+        ++solutions_by_mines_[mines];
+        for (std::size_t i = 0; i < size; ++i) {
+          if (GetComponentVar(i).value == 1) {
+            ++mine_counts_[i * (size + 1) + mines];
+          }
+        }
+        --depth_;
+      }
+      Var& var = GetComponentVar(depth_);
+      if (!Advance(var)) {
+        if (depth_ == 0) {
+          return true;
+        }
+        --depth_;
+      } else if (IsConsistent(var)) {
+        ++depth_;
+      }
+      if (++nodes_ > kMaxNodes) {
+        // Abandon the component, leaving its constraints as they were.
+        for (std::size_t i = 0; i < size; ++i) {
+          Var& var = GetComponentVar(i);
+          if (var.value >= 0) {
+            Unassign(var);
+          }
+        }
+        solutions_ = 0;
+        return true;
+      }
+      if (budget.Exhausted(++*steps)) {
+        return false;
+      }
+    }
+  }
+
+  // Records the results of the finished search of the current component,
+  // recommending actions for cells that are safe or a mine in every layout,
+  // then moves on to the next component.
+  void FinishComponent(std::vector<Action>* actions) {
+    const std::size_t cols = knowledge_->GetCols();
+    const std::size_t size = GetComponentSize();
+    if (solutions_ > 0) {
+      const std::vector<double> weights = GetLayoutWeights();
+      double total_weight = 0.0;
+      for (std::size_t k = 0; k <= size; ++k) {
+        total_weight += weights[k] * solutions_by_mines_[k];
+      }
+      for (std::size_t i = 0; i < size; ++i) {
+        const std::size_t index = GetComponentVar(i).index;
+        std::size_t count = 0;
+        double weight = 0.0;
+        for (std::size_t k = 0; k <= size; ++k) {
+          count += mine_counts_[i * (size + 1) + k];
+          weight += weights[k] * mine_counts_[i * (size + 1) + k];
+        }
+        if (count == 0) {
+          Recommend(Action::Type::UNCOVER, index / cols, index % cols, actions);
+        } else if (count == solutions_) {
+          Recommend(Action::Type::FLAG, index / cols, index % cols, actions);
+        } else if (total_weight > 0.0) {
+          probability_[index] = static_cast<float>(weight / total_weight);
+        } else {
+          // No layout leaves a number of mines the other cells can hold, so
+          // the layouts are counted equally.
+          probability_[index] = static_cast<float>(count) / solutions_;
+        }
+      }
+    }
+    ++component_;
+    StartComponent();
+  }
+
+  // Returns the weight of a layout of the current component with k mines, for
+  // each k, relative to the largest. The weight is the number of ways the
+  // mines left over can be placed among the unknown cells outside the
+  // component, C(other cells, mines left - k), or zero if they cannot be.
+  std::vector<double> GetLayoutWeights() const {
+    const std::size_t size = GetComponentSize();
+    const std::ptrdiff_t other_cells =
+        static_cast<std::ptrdiff_t>(unknown_cells_ - size);
+    const std::ptrdiff_t mines = GetUnflaggedMines();
+
+    // The possible values of k are those leaving between zero and other_cells
+    // mines. Successive weights differ by the factor
+    //   C(n, m - k) / C(n, m - k + 1) = (m - k + 1) / (n - m + k),
+    // so the logarithms are accumulated from the first possible k.
+    const std::ptrdiff_t first =
+        std::max<std::ptrdiff_t>(0, mines - other_cells);
+    const std::ptrdiff_t last =
+        std::min(static_cast<std::ptrdiff_t>(size), mines);
+    std::vector<double> weights(size + 1, 0.0);
+    if (first > last) {
+      return weights;
+    }
+    std::vector<double> log_weights(size + 1, 0.0);
+    double max_log_weight = 0.0;
+    for (std::ptrdiff_t k = first + 1; k <= last; ++k) {
+      log_weights[k] = log_weights[k - 1] +
+                       std::log(static_cast<double>(mines - k + 1) /
+                                static_cast<double>(other_cells - mines + k));
+      max_log_weight = std::max(max_log_weight, log_weights[k]);
+    }
+    for (std::ptrdiff_t k = first; k <= last; ++k) {
+      if (solutions_by_mines_[k] != 0) {
+        weights[k] = std::exp(log_weights[k] - max_log_weight);
+      }
+    }
+    return weights;
+  }
+
+  // The var for each cell, or -1.
+  std::vector<std::int32_t> var_index_;
+
+  // The probability that each cell is a mine, or -1 if not known.
+  std::vector<float> probability_;
+
+  std::vector<Var> vars_;
+  std::vector<Constraint> constraints_;
+
+  // The vars ordered by component. Component i is the range
+  // [component_begin_[i], component_begin_[i + 1]).
+  std::vector<std::uint32_t> order_;
+  std::vector<std::size_t> component_begin_;
+
+  // True once a pass has been built, at the knowledge version pass_version_.
+  bool has_pass_ = false;
+  std::uint64_t pass_version_ = 0;
+
+  // The state of a pass being built at the knowledge version build_version_.
+  // The next cell to examine is (build_row_, build_col_).
+  bool building_ = false;
+  std::uint64_t build_version_ = 0;
+  std::size_t build_row_ = 0;
+  std::size_t build_col_ = 0;
+
+  // The number of unknown cells, counted while building the pass.
+  std::size_t unknown_cells_ = 0;
+
+  // The state of the search of the current component.
+  std::size_t component_ = 0;
+  std::size_t depth_ = 0;
+  std::size_t nodes_ = 0;
+  std::size_t solutions_ = 0;
+  std::ptrdiff_t assigned_mines_ = 0;
+
+  // The number of solutions with each number of mines.
+  std::vector<std::size_t> solutions_by_mines_;
+
+  // The number of solutions with k mines in which var i is a mine, at
+  // [i * (size + 1) + k].
+  std::vector<std::size_t> mine_counts_;
+};
+
+// Uncovers the unknown cell least likely to be a mine.
+//
+// Cells bordering constraints use the probabilities found by the exact tier,
+// and all other unknown cells share the density of the mines left over. Ties
+// are broken by a hash of the game's seed and the cell's location, so that
+// equally good guesses are spread over the board rather than always made at
+// the same corner.
+class GuessTier : public Tier {
+ public:
+  GuessTier(Knowledge* knowledge, SolverCounters* counters,
+            const ExactTier* exact, unsigned seed)
+      : Tier(knowledge, counters), exact_(exact), key_(Mix64(seed)) {}
+
+  const char* GetName() const final { return "guess"; }
+
+  // Examining a cell is one step. A scan that runs out of budget continues
+  // from the same cell on the next call, unless the knowledge has changed in
+  // between.
+  AnalyzeStatus Analyze(const AnalyzeBudget& budget, std::size_t* steps,
+                        std::vector<Action>* actions) final {
+    const bool has_probabilities = exact_->HasProbabilities();
+    if (!scanning_ || scan_version_ != knowledge_->GetVersion() ||
+        scan_has_probabilities_ != has_probabilities) {
+      StartScan(has_probabilities);
+    }
+
+    const Grid<Knowledge::Cell>& grid = knowledge_->GetGrid();
+    for (; scan_row_ < grid.GetRows(); ++scan_row_, scan_col_ = 0) {
+      for (; scan_col_ < grid.GetCols(); ++scan_col_) {
+        if (budget.Exhausted(++*steps)) {
+          return AnalyzeStatus::INCOMPLETE;
+        }
+        Examine(scan_row_, scan_col_);
+      }
+    }
+    scanning_ = false;
+
+    // The cells without a known probability share the density of the mines
+    // that are not accounted for.
+    const double left = static_cast<double>(knowledge_->GetMines()) -
+                        static_cast<double>(knowledge_->GetFlags()) -
+                        known_mines_;
+    other_.probability =
+        other_cells_ == 0 ? 1.0
+                          : std::min(1.0, std::max(0.0, left / other_cells_));
+
+    const Candidate* best = nullptr;
+    if (known_.found && (!other_.found || known_.IsBetterThan(other_))) {
+      best = &known_;
+    } else if (other_.found) {
+      best = &other_;
+    }
+    if (best != nullptr) {
+      Recommend(Action::Type::UNCOVER, best->row, best->col, actions);
+    }
+    return AnalyzeStatus::COMPLETE;
+  }
+
+ private:
+  // The best cell found so far by a scan.
+  struct Candidate {
+    bool found = false;
+    double probability = 0.0;
+
+    // The hash that breaks ties.
+    std::uint64_t rank = 0;
+
+    std::size_t row = 0;
+    std::size_t col = 0;
+
+    bool IsBetterThan(const Candidate& other) const {
+      return probability < other.probability ||
+             (probability == other.probability && rank < other.rank);
+    }
+
+    // Replaces the candidate with the cell if the cell is better.
+    void Consider(double probability, std::uint64_t rank, std::size_t row,
+                  std::size_t col) {
+      Candidate cell;
+      cell.found = true;
+      cell.probability = probability;
+      cell.rank = rank;
+      cell.row = row;
+      cell.col = col;
+      if (!found || cell.IsBetterThan(*this)) {
+        *this = cell;
+      }
+    }
+  };
+
+  // Resets the scan to start from the first cell.
+  void StartScan(bool has_probabilities) {
+    scanning_ = true;
+    scan_version_ = knowledge_->GetVersion();
+    scan_has_probabilities_ = has_probabilities;
+    scan_row_ = 0;
+    scan_col_ = 0;
+    known_mines_ = 0.0;
+    other_cells_ = 0;
+    known_ = Candidate();
+    other_ = Candidate();
+  }
+
+  // Adds an unknown cell to the scan.
+  //
+  // The density of the cells without a known probability is not known until
+  // the scan finishes, and is the same for all of them, so they are compared
+  // by rank alone.
+  void Examine(std::size_t row, std::size_t col) {
+    if (!knowledge_->IsUnknown(row, col)) {
+      return;
+    }
+    const std::size_t index = knowledge_->GetIndex(row, col);
+    const float p =
+        scan_has_probabilities_ ? exact_->GetProbability(index) : -1.0f;
+    const std::uint64_t rank = Mix64(key_ ^ index);
+    if (p < 0) {
+      ++other_cells_;
+      other_.Consider(0.0, rank, row, col);
+    } else {
+      known_mines_ += p;
+      known_.Consider(p, rank, row, col);
+    }
+  }
+
+  const ExactTier* const exact_;
+
+  // The key hashed with each cell's index to rank the cell.
+  const std::uint64_t key_;
+
+  // The state of a scan of the knowledge version scan_version_. The next cell
+  // to examine is (scan_row_, scan_col_).
+  bool scanning_ = false;
+  std::uint64_t scan_version_ = 0;
+  bool scan_has_probabilities_ = false;
+  std::size_t scan_row_ = 0;
+  std::size_t scan_col_ = 0;
+
+  // The expected number of mines among the cells with a known probability.
+  double known_mines_ = 0.0;
+
+  // The number of cells without a known probability.
+  std::size_t other_cells_ = 0;
+
+  // The best cells with and without a known probability.
+  Candidate known_;
+  Candidate other_;
+};
+
+class TieredSolverImpl : public Solver {
+ public:
+  explicit TieredSolverImpl(const Game& game)
+      : knowledge_(game.GetRows(), game.GetCols(), game.GetMines()),
+        local_(&knowledge_, &counters_),
+        subset_(&knowledge_, &counters_),
+        exact_(&knowledge_, &counters_),
+        guess_(&knowledge_, &counters_, &exact_, game.GetSeed()),
+        tiers_{&local_, &subset_, &exact_, &guess_} {
+    counters_.tiers.resize(tiers_.size());
+    for (std::size_t i = 0; i < tiers_.size(); ++i) {
+      counters_.tiers[i].name = tiers_[i]->GetName();
+    }
+  }
+
+  ~TieredSolverImpl() final = default;
+
+  void NotifyEvent(const Event& event) final {
+    if (!knowledge_.GetGrid().IsValid(event.row, event.col)) {
+      return;
+    }
+    knowledge_.Apply(event);
+    for (Tier* tier : tiers_) {
+      tier->NotifyEvent(event);
+    }
+  }
+
+  // Runs the tiers in order, stopping at the first that produces actions or
+  // runs out of budget. A tier is only reached when every cheaper tier has
+  // finished without finding anything.
+  AnalyzeStatus Analyze(const AnalyzeBudget& budget,
+                        std::vector<Action>* actions) final {
+    MINES_INSTRUMENT(instrumentation::ScopedTimer timer(&counters_.analyze_ns));
+    MINES_INSTRUMENT(++counters_.analyze_calls);
+    if (knowledge_.IsGameOver()) {
+      return AnalyzeStatus::COMPLETE;
+    }
+
+    AnalyzeStatus status = AnalyzeStatus::COMPLETE;
+    const std::size_t initial_size = actions->size();
+    std::size_t steps = 0;
+    for (std::size_t i = 0; i < tiers_.size(); ++i) {
+      if (steps > 0 && budget.Exhausted(steps)) {
+        status = AnalyzeStatus::INCOMPLETE;
+        break;
+      }
+      MINES_INSTRUMENT(SolverCounters::TierCounters& tier = counters_.tiers[i]);
+      MINES_INSTRUMENT(++tier.calls);
+      {
+        MINES_INSTRUMENT(instrumentation::ScopedTimer tier_timer(&tier.ns));
+        status = tiers_[i]->Analyze(budget, &steps, actions);
+      }
+      if (actions->size() != initial_size) {
+        MINES_INSTRUMENT(++tier.hits);
+        MINES_INSTRUMENT(tier.actions += actions->size() - initial_size);
+        break;
+      }
+      if (status == AnalyzeStatus::INCOMPLETE) {
+        break;
+      }
+    }
+
+    MINES_INSTRUMENT(if (status == AnalyzeStatus::INCOMPLETE) {
+      ++counters_.incomplete_analyses;
+    });
+    MINES_INSTRUMENT(counters_.actions_produced +=
+                     actions->size() - initial_size);
+    return status;
+  }
+
+ private:
+  Knowledge knowledge_;
+  LocalTier local_;
+  SubsetTier subset_;
+  ExactTier exact_;
+  GuessTier guess_;
+
+  // The tiers, cheapest first.
+  const std::vector<Tier*> tiers_;
+};
+
+}  // namespace
+
+std::unique_ptr<Solver> New(const Game& game) {
+  return MakeUnique<TieredSolverImpl>(game);
+}
+
+}  // namespace tiered
+}  // namespace solver
+}  // namespace mines
@@ -0,0 +1,43 @@
+#ifndef MINES_SOLVER_TIERED_H_
+#define MINES_SOLVER_TIERED_H_
+
+#include <memory>
+
+#include "mines/game/game.h"
+#include "mines/solver/solver.h"
+
+namespace mines {
+namespace solver {
+namespace tiered {
+
+// A solver that tries a series of increasingly expensive strategies, moving
+// on to the next only when the cheaper ones cannot make progress:
+//  1. Local rules: a cell whose mines are all flagged has safe neighbors, and
+//     a cell with as many unknown neighbors as unflagged mines has only mines
+//     as neighbors.
+//  2. Pairs: two nearby cells whose unknown neighbors overlap, where the
+//     difference in their unflagged mines forces the cells that only one of
+//     them can see.
+//  3. Exact enumeration of the mine layouts consistent with each connected
+//     group of unknown cells bordering uncovered cells. Cells that are safe,
+//     or a mine, in every layout are uncovered or flagged.
+//  4. A guess: the unknown cell least likely to be a mine is uncovered. Ties
+//     are broken by a hash of the game's seed and the cell.
+//
+// All of the strategies share a single view of the game, built from its
+// events. Most moves are found by the local rules, so most moves cost about
+// as much as they do with the local solver.
+//
+// When instrumentation is enabled, the work done by each strategy is reported
+// in SolverCounters::tiers.
+//
+// The knowledge and the exact tier keep state for every cell, so the solver
+// is not suitable for boards over kMaxDenseGridCells cells; solver::New
+// refuses them.
+std::unique_ptr<Solver> New(const Game& game);
+
+}  // namespace tiered
+}  // namespace solver
+}  // namespace mines
+
+#endif  // MINES_SOLVER_TIERED_H_
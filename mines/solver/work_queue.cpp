@@ -0,0 +1,108 @@
+#include "mines/solver/work_queue.h"
+
+#include <algorithm>
+
+namespace mines {
+namespace solver {
+
+namespace {
+
+// The initial capacity of the ring buffer.
+constexpr std::size_t kInitialRingSize = 64;
+
+}  // namespace
+
+constexpr std::size_t WorkQueue::kPageSize;
+constexpr std::size_t WorkQueue::kPagesPerBlock;
+
+WorkQueue::WorkQueue(std::size_t size, Order order)
+    : order_(order),
+      stamps_((size + kPageSize * kPagesPerBlock - 1) /
+              (kPageSize * kPagesPerBlock)) {}
+
+bool WorkQueue::Push(std::size_t index, unsigned priority) {
+  if (Contains(index)) {
+    return false;
+  }
+  GetStamp(index) = epoch_;
+
+  if (order_ == Order::FIFO) {
+    if (size_ == ring_.size()) {
+      GrowRing();
+    }
+    std::size_t tail = head_ + size_;
+    if (tail >= ring_.size()) {
+      tail -= ring_.size();
+    }
+    ring_[tail] = index;
+  } else {
+    heap_.push(std::make_pair(priority, index));
+  }
+  ++size_;
+  return true;
+}
+
+std::size_t WorkQueue::Pop() {
+  std::size_t index;
+  if (order_ == Order::FIFO) {
+    index = ring_[head_];
+    if (++head_ == ring_.size()) {
+      head_ = 0;
+    }
+  } else {
+    index = heap_.top().second;
+    heap_.pop();
+  }
+  --size_;
+
+  // Any stamp other than the current epoch marks the cell as not queued.
+  GetStamp(index) = static_cast<std::uint16_t>(epoch_ - 1);
+  return index;
+}
+
+void WorkQueue::Clear() {
+  size_ = 0;
+  head_ = 0;
+  heap_ = decltype(heap_)();
+
+  // Advancing the epoch invalidates every stamp at once. When the epoch wraps
+  // around, old stamps could become valid again, so they are reset.
+  if (++epoch_ == 0) {
+    for (Block& block : stamps_) {
+      for (Page& page : block) {
+        std::fill(page.begin(), page.end(), 0);
+      }
+    }
+    epoch_ = 1;
+  }
+}
+
+std::uint16_t& WorkQueue::GetStamp(std::size_t index) {
+  const std::size_t page_index = index / kPageSize;
+  Block& block = stamps_[page_index / kPagesPerBlock];
+  if (block.empty()) {
+    block.resize(kPagesPerBlock);
+  }
+  Page& page = block[page_index % kPagesPerBlock];
+  if (page.empty()) {
+    page.resize(kPageSize, 0);
+  }
+  return page[index % kPageSize];
+}
+
+void WorkQueue::GrowRing() {
+  std::vector<std::size_t> ring(
+      std::max(kInitialRingSize, 2 * ring_.size()));
+  for (std::size_t i = 0; i < size_; ++i) {
+    std::size_t j = head_ + i;
+    if (j >= ring_.size()) {
+      j -= ring_.size();
+    }
+    ring[i] = ring_[j];
+  }
+  ring_.swap(ring);
+  head_ = 0;
+}
+
+}  // namespace solver
+}  // namespace mines
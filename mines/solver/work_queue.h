@@ -0,0 +1,125 @@
+#ifndef MINES_SOLVER_WORK_QUEUE_H_
+#define MINES_SOLVER_WORK_QUEUE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace mines {
+namespace solver {
+
+// A queue of cells awaiting analysis by a solver.
+//
+// Cells are identified by their linear index, e.g. as returned by
+// Grid::GetIndex. A cell can be in the queue at most once; pushing a cell that
+// is already queued does nothing. Membership is tracked with an epoch-stamped
+// array, so both the membership test and clearing the whole queue are O(1).
+//
+// Stamps are 16 bit values to keep the per-cell overhead at two bytes; the
+// stamps are reset once every 65535 calls to Clear. They are allocated in
+// pages of kPageSize cells the first time a cell in the page is pushed, and
+// the pages are found through blocks of kPagesPerBlock pages that are also
+// allocated on first use, so a queue for a very large sparse board only pays
+// for the cells it has seen.
+class WorkQueue {
+ public:
+  // The order in which cells are removed from the queue.
+  enum class Order {
+    // Cells are removed in the order they were pushed.
+    FIFO,
+
+    // Cells with the highest priority are removed first. Cells with equal
+    // priority are removed in an unspecified order.
+    PRIORITY,
+  };
+
+  // The number of consecutive indices whose stamps are allocated together.
+  // This matches the cells in a TiledGrid tile.
+  static constexpr std::size_t kPageSize = 4096;
+
+  // The number of consecutive pages whose entries are allocated together.
+  static constexpr std::size_t kPagesPerBlock = 4096;
+
+  // Creates a queue for cells with indices in the range [0, size).
+  explicit WorkQueue(std::size_t size, Order order = Order::FIFO);
+
+  ~WorkQueue() = default;
+
+  // Copyable.
+  WorkQueue(const WorkQueue&) = default;
+  WorkQueue& operator=(const WorkQueue&) = default;
+
+  // Movable.
+  WorkQueue(WorkQueue&&) = default;
+  WorkQueue& operator=(WorkQueue&&) = default;
+
+  // Adds a cell to the queue.
+  //
+  // The priority is ignored unless the queue was created with Order::PRIORITY.
+  // The priority of a cell is fixed when it is pushed.
+  //
+  // Returns false (and does nothing) if the cell was already in the queue.
+  bool Push(std::size_t index, unsigned priority = 0);
+
+  // Removes and returns the next cell from the queue.
+  //
+  // The queue must not be empty.
+  std::size_t Pop();
+
+  // Returns true if the cell is in the queue.
+  bool Contains(std::size_t index) const {
+    const std::size_t page_index = index / kPageSize;
+    const Block& block = stamps_[page_index / kPagesPerBlock];
+    if (block.empty()) {
+      return false;
+    }
+    const Page& page = block[page_index % kPagesPerBlock];
+    return !page.empty() && page[index % kPageSize] == epoch_;
+  }
+
+  // Returns true if the queue is empty.
+  bool Empty() const { return size_ == 0; }
+
+  // Returns the number of cells in the queue.
+  std::size_t Size() const { return size_; }
+
+  // Removes all cells from the queue.
+  void Clear();
+
+ private:
+  using Page = std::vector<std::uint16_t>;
+  using Block = std::vector<Page>;
+
+  // Doubles the capacity of the ring buffer, preserving the queued cells.
+  void GrowRing();
+
+  Order order_;
+
+  // Returns the stamp of a cell, allocating its page if necessary.
+  std::uint16_t& GetStamp(std::size_t index);
+
+  // A cell is in the queue if and only if its stamp equals the current epoch.
+  // The stamps are held in pages of kPageSize, grouped into blocks of
+  // kPagesPerBlock. An empty page or block has never been used.
+  std::vector<Block> stamps_;
+  std::uint16_t epoch_ = 1;
+
+  // The number of cells in the queue.
+  std::size_t size_ = 0;
+
+  // Ring buffer used for Order::FIFO. The buffer grows as needed, but since
+  // each cell is in the queue at most once it never grows beyond the number of
+  // cells.
+  std::vector<std::size_t> ring_;
+  std::size_t head_ = 0;
+
+  // Heap used for Order::PRIORITY.
+  std::priority_queue<std::pair<unsigned, std::size_t>> heap_;
+};
+
+}  // namespace solver
+}  // namespace mines
+
+#endif  // MINES_SOLVER_WORK_QUEUE_H_
@@ -0,0 +1,91 @@
+#include "mines/ui/cell_region.h"
+
+namespace mines {
+namespace ui {
+namespace detail {
+
+constexpr std::size_t DirtyRegion::kMaxRegions;
+
+void DirtyRegion::Reset(std::size_t rows) {
+  spans_.assign(rows, Span());
+  dirty_rows_.clear();
+  regions_.clear();
+}
+
+void DirtyRegion::Include(std::size_t row, std::size_t col) {
+  Span& span = spans_[row];
+  if (!span.dirty) {
+    span.dirty = true;
+    span.min_col = col;
+    span.max_col = col;
+    dirty_rows_.push_back(row);
+    return;
+  }
+  span.min_col = std::min(col, span.min_col);
+  span.max_col = std::max(col, span.max_col);
+}
+
+void DirtyRegion::Include(const CellRegion& region) {
+  for (std::size_t row = region.min_row; row <= region.max_row; ++row) {
+    Include(row, region.min_col);
+    Include(row, region.max_col);
+  }
+}
+
+const std::vector<CellRegion>& DirtyRegion::Flush() {
+  regions_.clear();
+  std::sort(dirty_rows_.begin(), dirty_rows_.end());
+
+  // The number of dirty span cells in the last region, used to avoid merging
+  // spans whose bounding box would be mostly clean (e.g. a diagonal line).
+  std::size_t last_dirty_cells = 0;
+  for (std::size_t row : dirty_rows_) {
+    Span& span = spans_[row];
+    const std::size_t width = span.max_col - span.min_col + 1;
+    if (!regions_.empty()) {
+      CellRegion& last = regions_.back();
+      if (last.max_row + 1 == row && span.min_col <= last.max_col + 1 &&
+          span.max_col + 1 >= last.min_col) {
+        CellRegion merged = last;
+        merged.Include(row, span.min_col);
+        merged.Include(row, span.max_col);
+        if (merged.GetArea() <= 2 * (last_dirty_cells + width)) {
+          last = merged;
+          last_dirty_cells += width;
+          span = Span();
+          continue;
+        }
+      }
+    }
+    regions_.emplace_back(row, span.min_col);
+    regions_.back().Include(row, span.max_col);
+    last_dirty_cells = width;
+    span = Span();
+  }
+  dirty_rows_.clear();
+
+  LimitRegions();
+  return regions_;
+}
+
+void DirtyRegion::LimitRegions() {
+  if (regions_.size() <= kMaxRegions) {
+    return;
+  }
+  // Combine runs of consecutive regions into bands of rows.
+  const std::size_t run = (regions_.size() + kMaxRegions - 1) / kMaxRegions;
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < regions_.size(); i += run) {
+    CellRegion band = regions_[i];
+    const std::size_t end = std::min(i + run, regions_.size());
+    for (std::size_t j = i + 1; j < end; ++j) {
+      band.Include(regions_[j]);
+    }
+    regions_[count++] = band;
+  }
+  regions_.resize(count, regions_.front());
+}
+
+}  // namespace detail
+}  // namespace ui
+}  // namespace mines
@@ -0,0 +1,104 @@
+#ifndef MINES_UI_CELL_REGION_H_
+#define MINES_UI_CELL_REGION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace mines {
+namespace ui {
+namespace detail {
+
+// A rectangular region of one or more cells, represented as the location of
+// the top left and bottom right cells.
+struct CellRegion {
+  // Constructs a cell region containing the specified cell.
+  CellRegion(std::size_t row, std::size_t col) {
+    min_row = row;
+    max_row = row;
+    min_col = col;
+    max_col = col;
+  }
+
+  // Ensures that the specified cell is included in the region.
+  void Include(std::size_t row, std::size_t col) {
+    min_row = std::min(row, min_row);
+    max_row = std::max(row, max_row);
+    min_col = std::min(col, min_col);
+    max_col = std::max(col, max_col);
+  }
+
+  // Ensures that the specified region is included in the region.
+  void Include(const CellRegion& region) {
+    Include(region.min_row, region.min_col);
+    Include(region.max_row, region.max_col);
+  }
+
+  // Returns the number of cells in the region.
+  std::size_t GetArea() const {
+    return (max_row - min_row + 1) * (max_col - min_col + 1);
+  }
+
+  std::size_t min_row;
+  std::size_t max_row;
+  std::size_t min_col;
+  std::size_t max_col;
+};
+
+// An arbitrary set of cells needing to be redrawn, accumulated over a frame
+// and then flushed as a few rectangular regions.
+//
+// Each row keeps the span of columns between its leftmost and rightmost dirty
+// cell, so including a cell is constant time and flushing is linear in the
+// number of dirty rows.
+class DirtyRegion {
+ public:
+  // The most regions returned by Flush. Beyond this, adjacent regions are
+  // merged even if that includes many clean cells.
+  static constexpr std::size_t kMaxRegions = 16;
+
+  // Clears the region and sizes it for a mine field with the specified number
+  // of rows.
+  void Reset(std::size_t rows);
+
+  // Adds the specified cell.
+  void Include(std::size_t row, std::size_t col);
+
+  // Adds every cell in the specified region.
+  void Include(const CellRegion& region);
+
+  // Returns true if no cells have been added since the last flush.
+  bool IsEmpty() const { return dirty_rows_.empty(); }
+
+  // Merges the dirty cells into at most kMaxRegions rectangles, ordered by
+  // row, and clears the dirty cells.
+  //
+  // The returned vector is valid until the next call to a non-const method.
+  const std::vector<CellRegion>& Flush();
+
+ private:
+  // The dirty columns of a row.
+  struct Span {
+    bool dirty = false;
+    std::size_t min_col = 0;
+    std::size_t max_col = 0;
+  };
+
+  // Merges consecutive regions until there are at most kMaxRegions.
+  void LimitRegions();
+
+  // The dirty span of each row.
+  std::vector<Span> spans_;
+
+  // The rows with a dirty span, in the order they were first added.
+  std::vector<std::size_t> dirty_rows_;
+
+  // The regions produced by the last flush.
+  std::vector<CellRegion> regions_;
+};
+
+}  // namespace detail
+}  // namespace ui
+}  // namespace mines
+
+#endif  // MINES_UI_CELL_REGION_H_
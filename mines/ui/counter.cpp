@@ -1,5 +1,7 @@
 #include "mines/ui/counter.h"
 
+#include <algorithm>
+
 #include <gdkmm/general.h>
 #include <glibmm/ustring.h>
 
@@ -17,6 +19,9 @@ constexpr std::size_t kDigitHeight = 40;
 // The number of counter digits.
 constexpr std::size_t kNumDigits = 3;
 
+// The largest value the digits can show.
+constexpr std::size_t kMaxValue = 999;
+
 // The width of the drawn portion of a counter widget.
 constexpr std::size_t kWidth = kNumDigits * kDigitWidth;
 
@@ -31,19 +36,60 @@ constexpr const char* kDigitResourcePathFormat =
 constexpr const char* kDigitOffResourcePath =
     "/com/alanwj/mines-solver/digit-off.bmp";
 
+// The position in the digit strip of the digit that is turned off. Digits 0
+// to 9 precede it.
+constexpr std::size_t kDigitOff = 10;
+
+namespace {
+
+// Returns a surface holding every digit image side by side, decoding the
+// resources on the first call.
+Cairo::RefPtr<Cairo::ImageSurface> GetDigitStrip() {
+  static Cairo::RefPtr<Cairo::ImageSurface> strip;
+  if (strip) {
+    return strip;
+  }
+
+  strip = Cairo::ImageSurface::create(Cairo::FORMAT_RGB24,
+                                      (kDigitOff + 1) * kDigitWidth,
+                                      kDigitHeight);
+  Cairo::RefPtr<Cairo::Context> cr = Cairo::Context::create(strip);
+  for (std::size_t i = 0; i <= kDigitOff; ++i) {
+    const Glib::ustring path =
+        i == kDigitOff ? Glib::ustring(kDigitOffResourcePath)
+                       : Glib::ustring::compose(kDigitResourcePathFormat, i);
+    Gdk::Cairo::set_source_pixbuf(
+        cr,
+        compat::CreatePixbufFromResource(path.c_str(), kDigitWidth,
+                                         kDigitHeight),
+        kDigitWidth * i, 0);
+    cr->rectangle(kDigitWidth * i, 0, kDigitWidth, kDigitHeight);
+    cr->fill();
+  }
+  return strip;
+}
+
+}  // namespace
+
 Counter::Counter(BaseObjectType* cobj, const Glib::RefPtr<Gtk::Builder>&)
     : Gtk::DrawingArea(cobj) {
   set_size_request(kWidth, kHeight);
 }
 
 void Counter::SetValue(std::size_t value) {
+  value = std::min(value, kMaxValue);
+
+  // The elapsed time counter sets its value far more often than it changes.
+  if (value == value_) {
+    return;
+  }
   value_ = value;
   queue_draw();
 }
 
 void Counter::on_realize() {
   Gtk::DrawingArea::on_realize();
-  LoadPixbufs();
+  digits_ = GetDigitStrip();
 }
 
 bool Counter::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
@@ -53,28 +99,18 @@ bool Counter::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
     std::size_t d = value % 10;
     value /= 10;
 
-    Glib::RefPtr<Gdk::Pixbuf> pixbuf;
     if (d == 0 && value == 0 && i != kNumDigits - 1) {
-      pixbuf = digit_off_;
-    } else {
-      pixbuf = digit_[d];
+      d = kDigitOff;
     }
-    Gdk::Cairo::set_source_pixbuf(cr, pixbuf, kDigitWidth * i, 0);
-    cr->paint();
+    // Align digit d of the strip with position i of the counter.
+    const double x = kDigitWidth * i;
+    cr->set_source(digits_, x - kDigitWidth * d, 0);
+    cr->rectangle(x, 0, kDigitWidth, kDigitHeight);
+    cr->fill();
   }
 
   return false;
 }
 
-void Counter::LoadPixbufs() {
-  for (std::size_t i = 0; i < 10; ++i) {
-    digit_[i] = compat::CreatePixbufFromResource(
-        Glib::ustring::compose(kDigitResourcePathFormat, i).c_str(),
-        kDigitWidth, kDigitHeight);
-    digit_off_ = compat::CreatePixbufFromResource(kDigitOffResourcePath,
-                                                  kDigitWidth, kDigitHeight);
-  }
-}
-
 }  // namespace ui
 }  // namespace mines
@@ -5,7 +5,7 @@
 
 #include <cairomm/context.h>
 #include <cairomm/refptr.h>
-#include <gdkmm/pixbuf.h>
+#include <cairomm/surface.h>
 #include <glibmm/refptr.h>
 #include <gtkmm/builder.h>
 #include <gtkmm/drawingarea.h>
@@ -21,7 +21,8 @@ class Counter : public Gtk::DrawingArea {
   // This constructor supports Gtk::Builder::get_widget_derived.
   Counter(BaseObjectType* cobj, const Glib::RefPtr<Gtk::Builder>&);
 
-  // Sets the value to display in the widget.
+  // Sets the value to display in the widget. Values too large for the digits
+  // are shown as 999.
   void SetValue(std::size_t value);
 
  private:
@@ -31,12 +32,8 @@ class Counter : public Gtk::DrawingArea {
   // Handler for the draw signal.
   bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) final;
 
-  // Loads all of the necessary pixbufs from the global resources.
-  void LoadPixbufs();
-
-  // Pixbufs necessary for rendering.
-  Glib::RefPtr<Gdk::Pixbuf> digit_[10];
-  Glib::RefPtr<Gdk::Pixbuf> digit_off_;
+  // The images of every digit side by side, shared by all counters.
+  Cairo::RefPtr<Cairo::ImageSurface> digits_;
 
   // The current counter value.
   std::size_t value_ = 0;
@@ -1,16 +1,24 @@
 #include "mines/ui/game_window.h"
 
+#include <cstdio>
 #include <ctime>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <sigc++/functors/mem_fun.h>
 
+#include "mines/compat/make_unique.h"
+#include "mines/game/instrumentation.h"
+
 namespace mines {
 namespace ui {
 
 const GameWindow::Difficulty GameWindow::kBeginnerDifficulty = {8, 8, 10};
 const GameWindow::Difficulty GameWindow::kIntermediateDifficulty = {16, 16, 40};
 const GameWindow::Difficulty GameWindow::kExpertDifficulty = {16, 30, 99};
+const GameWindow::Difficulty GameWindow::kHugeDifficulty = {1000, 1000,
+                                                            100000};
 
 GameWindow* GameWindow::Get(const Glib::RefPtr<Gtk::Builder>& builder,
                             const Difficulty& difficulty) {
@@ -34,8 +42,16 @@ GameWindow::GameWindow(BaseObjectType* cobj,
       elapsed_time_counter_(ElapsedTimeCounter::Get(builder)),
       solver_algorithm_(solver::Algorithm::NONE) {
   add_action("new", sigc::mem_fun(this, &GameWindow::NewGame));
+  add_action("dump-counters", sigc::mem_fun(this, &GameWindow::DumpCounters));
+  add_action("stop-solver", sigc::mem_fun(this, &GameWindow::StopSolver));
+  add_action("zoom-in", sigc::mem_fun(mine_field_, &MineField::ZoomIn));
+  add_action("zoom-out", sigc::mem_fun(mine_field_, &MineField::ZoomOut));
+  add_action("zoom-fit", sigc::mem_fun(mine_field_, &MineField::ZoomToFit));
   solver_action_ = add_action_radio_string(
       "solver", sigc::mem_fun(this, &GameWindow::NewSolverAlgorithm), "none");
+  instant_action_ = add_action_bool(
+      "instant", sigc::mem_fun(this, &GameWindow::ToggleInstantUpdates),
+      false);
 
   mine_field_->signal_action().connect(
       sigc::mem_fun(this, &GameWindow::HandleAction));
@@ -47,7 +63,19 @@ GameWindow::GameWindow(BaseObjectType* cobj,
 void GameWindow::NewGame() {
   game_ = mines::NewGame(difficulty_.rows, difficulty_.cols, difficulty_.mines,
                          std::time(nullptr));
-  solver_ = solver::New(solver_algorithm_, *game_);
+  std::unique_ptr<solver::Solver> solver =
+      solver::NewUnsubscribed(solver_algorithm_, *game_);
+  if (solver == nullptr) {
+    std::fprintf(stderr,
+                 "the selected solver does not support a %zux%zu board; "
+                 "no solver will be used\n",
+                 difficulty_.rows, difficulty_.cols);
+    solver = solver::NewUnsubscribed(solver::Algorithm::NONE, *game_);
+  }
+  solver_worker_ = MakeUnique<SolverWorker>(std::move(solver));
+  solver_worker_->signal_actions().connect(
+      sigc::mem_fun(this, &GameWindow::HandleSolverActions));
+  game_->Subscribe(solver_worker_.get());
 
   // Subscribe UI widgets to the new game, causing them to reset.
   game_->Subscribe(mine_field_);
@@ -63,6 +91,8 @@ void GameWindow::NewSolverAlgorithm(const Glib::ustring& target) {
     solver_algorithm_ = solver::Algorithm::NONE;
   } else if (target == "local") {
     solver_algorithm_ = solver::Algorithm::LOCAL;
+  } else if (target == "tiered") {
+    solver_algorithm_ = solver::Algorithm::TIERED;
   } else {
     solver_algorithm_ = solver::Algorithm::NONE;
   }
@@ -70,15 +100,40 @@ void GameWindow::NewSolverAlgorithm(const Glib::ustring& target) {
   NewGame();
 }
 
+void GameWindow::ToggleInstantUpdates() {
+  bool instant = false;
+  instant_action_->get_state(instant);
+  instant = !instant;
+  instant_action_->change_state(instant);
+
+  mine_field_->SetAnimationRate(instant ? 0
+                                        : MineField::kDefaultCellsPerSecond);
+}
+
+void GameWindow::DumpCounters() {
+  if (!instrumentation::kEnabled) {
+    std::fprintf(stderr,
+                 "counters are only available when built with "
+                 "--enable-instrumentation\n");
+    return;
+  }
+  mines::PrintCounters(game_->GetCounters(), stderr);
+  solver::PrintCounters(solver_worker_->GetCounters(), stderr);
+}
+
+void GameWindow::StopSolver() { solver_worker_->Cancel(); }
+
 void GameWindow::HandleAction(Action action) {
   game_->Execute(action);
+  solver_worker_->Analyze();
+}
 
-  // Execute all actions recommended by the solver.
-  std::vector<Action> actions;
-  do {
-    actions = solver_->Analyze();
-    game_->Execute(actions);
-  } while (!actions.empty());
+void GameWindow::HandleSolverActions(const std::vector<Action>& actions) {
+  if (actions.empty()) {
+    return;
+  }
+  game_->Execute(actions);
+  solver_worker_->Analyze();
 }
 
 }  // namespace ui
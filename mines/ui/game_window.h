@@ -3,6 +3,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 #include <giomm/simpleaction.h>
 #include <glibmm/refptr.h>
@@ -16,6 +17,7 @@
 #include "mines/ui/mine_field.h"
 #include "mines/ui/remaining_mines_counter.h"
 #include "mines/ui/reset_button.h"
+#include "mines/ui/solver_worker.h"
 
 namespace mines {
 namespace ui {
@@ -34,6 +36,7 @@ class GameWindow : public Gtk::ApplicationWindow {
   static const Difficulty kBeginnerDifficulty;
   static const Difficulty kIntermediateDifficulty;
   static const Difficulty kExpertDifficulty;
+  static const Difficulty kHugeDifficulty;
 
   // Gets the GameWindow from the builder.
   static GameWindow* Get(const Glib::RefPtr<Gtk::Builder>& builder,
@@ -51,11 +54,26 @@ class GameWindow : public Gtk::ApplicationWindow {
   // Changes the solver algorithm and starts a new game.
   void NewSolverAlgorithm(const Glib::ustring& target);
 
+  // Toggles whether events are shown as soon as they happen rather than
+  // animated.
+  void ToggleInstantUpdates();
+
+  // Writes the game and solver counters to stderr.
+  void DumpCounters();
+
+  // Stops executing the solver's actions until the next action on the mine
+  // field.
+  void StopSolver();
+
   // Handles an action on the mine field.
   //
-  // Executes the action, updates the mine field, and runs the solver.
+  // Executes the action, updates the mine field, and starts the solver.
   void HandleAction(Action action);
 
+  // Executes the actions recommended by the solver and, if there were any,
+  // asks it for more.
+  void HandleSolverActions(const std::vector<Action>& actions);
+
   // The mine field.
   MineField* mine_field_;
 
@@ -71,6 +89,9 @@ class GameWindow : public Gtk::ApplicationWindow {
   // Menu action for selection the solver algorithm.
   Glib::RefPtr<Gio::SimpleAction> solver_action_;
 
+  // Menu action for showing events without animation.
+  Glib::RefPtr<Gio::SimpleAction> instant_action_;
+
   // The algorithm used in current and new games.
   solver::Algorithm solver_algorithm_;
 
@@ -80,8 +101,8 @@ class GameWindow : public Gtk::ApplicationWindow {
   // The current game.
   std::unique_ptr<Game> game_;
 
-  // The current solver.
-  std::unique_ptr<solver::Solver> solver_;
+  // The current solver, running on a background thread.
+  std::unique_ptr<SolverWorker> solver_worker_;
 };
 
 }  // namespace ui
@@ -2,304 +2,111 @@
 
 #include <algorithm>
 
-#include <cairomm/enums.h>
-#include <cairomm/types.h>
-#include <gdkmm/general.h>
-#include <glibmm/main.h>
+#include <gtkmm/adjustment.h>
 #include <sigc++/functors/mem_fun.h>
 
-#include "mines/compat/gdk_pixbuf.h"
+#include "mines/compat/make_unique.h"
 
 namespace mines {
 namespace ui {
 
 using detail::Cell;
-using detail::DrawingDimensions;
-using detail::Pixbufs;
+using detail::CellRegion;
+using detail::kFrameSize;
 
 namespace {
 
-// The size of the frame around the mine field.
-constexpr std::size_t kFrameSize = 1;
-
-// The default (and minimum) cell size.
+// The cell size used to choose the size requested by the widget.
 constexpr std::size_t kCellSize = 20;
 
-// The time (in milliseconds) between processing each event.
-// A small visual delay between events gives a natural feel when areas are
-// uncovered.
-constexpr unsigned int kEventTimeoutMs = 1;
-
-// Resource path for the mine graphic.
-constexpr const char* kMineResourcePath = "/com/alanwj/mines-solver/mine.svg";
-
-// Resource path for the flag graphic.
-constexpr const char* kFlagResourcePath = "/com/alanwj/mines-solver/flag.svg";
-
-// Encapsulates a simple RGB color.
-struct Color {
-  double r;
-  double g;
-  double b;
-};
-
-// The color to use for numbers 1 through 8.
-constexpr std::array<Color, 8> kNumberColor{{
-    {0.0, 0.0, 1.0},  // 1
-    {0.0, 0.5, 0.0},  // 2
-    {1.0, 0.0, 0.0},  // 3
-    {0.0, 0.0, 0.5},  // 4
-    {0.5, 0.0, 0.0},  // 5
-    {0.0, 0.5, 0.5},  // 6
-    {0.5, 0.0, 0.5},  // 7
-    {0.0, 0.0, 0.0},  // 8
-}};
-
-// Colors used in widget construction.
-constexpr Color kFrameColor{0.5, 0.5, 0.5};
-constexpr Color kCellColor{0.76, 0.76, 0.76};
-constexpr Color kLosingMineCellColor{1.0, 0.0, 0.0};
-constexpr Color kCellBorderColor{0.5, 0.5, 0.5};
-constexpr Color kLightBevelColor{1.0, 1.0, 1.0};
-constexpr Color kDarkBevelColor{0.5, 0.5, 0.5};
-
-// Sets the source color in the specified context.
-void SetColor(const Cairo::RefPtr<Cairo::Context>& cr, const Color& color) {
-  cr->set_source_rgb(color.r, color.g, color.b);
-}
-
-// A flyweight class to encapsulate the process of drawing a cell.
-//
-// This exists primarily to separate this drawing logic from the MineField class
-// to prevent it from growing too complex.
-class CellDrawFlyweight {
- public:
-  CellDrawFlyweight(const Cairo::RefPtr<Cairo::Context>& cr,
-                    const DrawingDimensions& dim, const Pixbufs& pixbufs,
-                    const Cell& cell, std::size_t row, std::size_t col)
-      : cr_(cr),
-        dim_(dim),
-        pixbufs_(pixbufs),
-        cell_(cell),
-        row_(row),
-        col_(col) {}
-
-  CellDrawFlyweight(const CellDrawFlyweight&) = delete;
-  CellDrawFlyweight& operator=(const CellDrawFlyweight&) = delete;
-  CellDrawFlyweight(CellDrawFlyweight&&) = delete;
-  CellDrawFlyweight& operator=(CellDrawFlyweight&&) = delete;
-
-  void Draw() const {
-    switch (cell_.state) {
-      case CellState::UNCOVERED:
-        DrawUncovered();
-        break;
-      case CellState::COVERED:
-        if (cell_.pressed) {
-          DrawPressed();
-        } else {
-          DrawCovered();
-        }
-        break;
-      case CellState::FLAGGED:
-        DrawFlagged();
-        break;
-      case CellState::MINE:
-        DrawMine();
-        break;
-      case CellState::LOSING_MINE:
-        DrawLosingMine();
-        break;
-      case CellState::BAD_FLAG:
-        DrawBadFlag();
-        break;
-    };
-  }
-
- private:
-  // Fills the cell with the specified color.
-  void FillCell(const Color& color) const {
-    SetColor(cr_, color);
-    cr_->rectangle(0.0, 0.0, dim_.cell_size, dim_.cell_size);
-    cr_->fill();
-  }
-
-  // Draws a sharp single pixel horizontal line of the specified width.
-  void DrawHLine(std::size_t x, std::size_t y, std::size_t width) const {
-    cr_->save();
-    cr_->translate(0.5, 0.5);
-    cr_->move_to(x, y);
-    cr_->line_to(x + width - 1, y);
-    cr_->restore();
-  }
-
-  // Draws a sharp single pixel vertical line of the specified height.
-  void DrawVLine(std::size_t x, std::size_t y, std::size_t height) const {
-    cr_->save();
-    cr_->translate(0.5, 0.5);
-    cr_->move_to(x, y);
-    cr_->line_to(x, y + height - 1);
-    cr_->restore();
-  }
-
-  // Draws a character in a cell.
-  void DrawChar(char c) const {
-    const char str[2] = {c, '\0'};
-
-    cr_->select_font_face("cairo:monospace", Cairo::FONT_SLANT_NORMAL,
-                          Cairo::FONT_WEIGHT_BOLD);
-    // Empirically, 9/10 of the cell looks pretty good.
-    cr_->set_font_size(.9 * dim_.cell_size);
-    Cairo::TextExtents te;
-    cr_->get_text_extents(str, te);
-
-    cr_->move_to(dim_.cell_size / 2 - te.width / 2 - te.x_bearing,
-                 dim_.cell_size / 2 - te.height / 2 - te.y_bearing);
-    cr_->show_text(str);
-  }
-
-  // Draws an empty cell.
-  void DrawEmpty(const Color& color) const {
-    FillCell(color);
-    SetColor(cr_, kCellBorderColor);
-    if (row_ != 0) {
-      DrawHLine(0, 0, dim_.cell_size);
-    }
-    if (col_ != 0) {
-      DrawVLine(0, 0, dim_.cell_size);
-    }
-    cr_->stroke();
-  }
-
-  // Draws a cell in the UNCOVERED state with the number of adjacent mines.
-  void DrawUncovered() const {
-    DrawEmpty(kCellColor);
-    if (cell_.adjacent_mines > 0 && cell_.adjacent_mines <= 8) {
-      SetColor(cr_, kNumberColor[cell_.adjacent_mines - 1]);
-      DrawChar('0' + cell_.adjacent_mines);
-    }
-  }
-
-  // Draws a cell that is visually pressed by a mouse action.
-  void DrawPressed() const {
-    FillCell(kCellColor);
-    SetColor(cr_, kDarkBevelColor);
-    DrawHLine(0, 0, dim_.cell_size);
-    DrawVLine(0, 0, dim_.cell_size);
-    cr_->stroke();
-  }
-
-  // Draws a cell in the COVERED state.
-  void DrawCovered() const {
-    FillCell(kCellColor);
-
-    // Light bevel on top.
-    SetColor(cr_, kLightBevelColor);
-    DrawHLine(0, 0, dim_.cell_size - 1);
-    DrawHLine(0, 1, dim_.cell_size - 2);
-
-    // Light bevel on left.
-    DrawVLine(0, 0, dim_.cell_size - 1);
-    DrawVLine(1, 0, dim_.cell_size - 2);
-    cr_->stroke();
-
-    // Dark bevel on bottom.
-    SetColor(cr_, kDarkBevelColor);
-    DrawHLine(1, dim_.cell_size - 1, dim_.cell_size - 1);
-    DrawHLine(2, dim_.cell_size - 2, dim_.cell_size - 2);
-
-    // Dark bevel on right.
-    DrawVLine(dim_.cell_size - 1, 1, dim_.cell_size - 1);
-    DrawVLine(dim_.cell_size - 2, 2, dim_.cell_size - 2);
-    cr_->stroke();
-  }
-
-  // Draws the provided pixbuf in the center of the cell.
-  void DrawPixbuf(const Glib::RefPtr<Gdk::Pixbuf>& pixbuf) const {
-    cr_->save();
-    Gdk::Cairo::set_source_pixbuf(
-        cr_, pixbuf, dim_.cell_size / 2 - pixbuf->get_width() / 2,
-        dim_.cell_size / 2 - pixbuf->get_height() / 2);
-    cr_->paint();
-    cr_->restore();
-  }
-
-  // Draws a cell in the FLAGGED state.
-  void DrawFlagged() const {
-    DrawCovered();
-    DrawPixbuf(pixbufs_.flag);
-  }
-
-  // Draws a cell in the MINE state.
-  void DrawMine() const {
-    DrawEmpty(kCellColor);
-    DrawPixbuf(pixbufs_.mine);
-  }
+// The most requested in either direction, so that large mine fields are viewed
+// through scrollbars rather than demanding a huge window.
+constexpr std::size_t kMaxSizeRequest = 640;
 
-  // Draws a cell in the LOSING_MINE state.
-  void DrawLosingMine() const {
-    DrawEmpty(kLosingMineCellColor);
-    DrawPixbuf(pixbufs_.mine);
-  }
-
-  // Draws a cell in the BAD_FLAG state.
-  void DrawBadFlag() const {
-    DrawFlagged();
-    cr_->save();
-    SetColor(cr_, {1.0, 0.0, 0.0});
-    cr_->scale(dim_.cell_size, dim_.cell_size);
-    cr_->set_line_width(.15);
-    cr_->set_line_cap(Cairo::LINE_CAP_ROUND);
+// Below this cell size, cells are drawn from the color map.
+constexpr std::size_t kMinDetailCellSize = 8;
 
-    const double margin = .15;
-    cr_->move_to(margin, margin);
-    cr_->line_to(1.0 - margin, 1.0 - margin);
-    cr_->move_to(margin, 1.0 - margin);
-    cr_->line_to(1.0 - margin, margin);
-    cr_->stroke();
+// The cell sizes stepped through by zooming.
+constexpr std::size_t kZoomLevels[] = {1,  2,  3,  4,  6,  8, 12,
+                                       16, 20, 24, 32, 48, 64};
 
-    cr_->restore();
-  }
+// The number of steps scrolled by one turn of the mouse wheel.
+constexpr double kWheelSteps = 3.0;
 
-  const Cairo::RefPtr<Cairo::Context>& cr_;
-  const DrawingDimensions& dim_;
-  const Pixbufs& pixbufs_;
-  const Cell& cell_;
-  const std::size_t row_;
-  const std::size_t col_;
-};
+// The largest backing surface, in pixels, that will be kept for the mine
+// field (64MB at 4 bytes per pixel).
+constexpr std::size_t kMaxBackingPixels = 16 * 1024 * 1024;
 
 }  // namespace
 
+constexpr std::size_t MineField::kDefaultCellsPerSecond;
+
 MineField* MineField::Get(const Glib::RefPtr<Gtk::Builder>& builder) {
   MineField* mine_field = nullptr;
   builder->get_widget_derived("mine-field", mine_field);
   return mine_field;
 }
 
-MineField::MineField(BaseObjectType* cobj, const Glib::RefPtr<Gtk::Builder>&)
-    : Gtk::DrawingArea(cobj) {}
+MineField::MineField(BaseObjectType* cobj,
+                     const Glib::RefPtr<Gtk::Builder>& builder)
+    : Gtk::DrawingArea(cobj), cells_per_second_(kDefaultCellsPerSecond) {
+  builder->get_widget("mine-field-hscrollbar", hscrollbar_);
+  builder->get_widget("mine-field-vscrollbar", vscrollbar_);
+  hscrollbar_->get_adjustment()->signal_value_changed().connect(
+      sigc::mem_fun(*this, &MineField::OnScrollbarChanged));
+  vscrollbar_->get_adjustment()->signal_value_changed().connect(
+      sigc::mem_fun(*this, &MineField::OnScrollbarChanged));
+}
+
+void MineField::SetAnimationRate(std::size_t cells_per_second) {
+  cells_per_second_ = cells_per_second;
+}
+
+void MineField::ZoomIn() {
+  SetZoom(GetZoomStep(true), get_allocated_width() / 2.0,
+          get_allocated_height() / 2.0);
+}
+
+void MineField::ZoomOut() {
+  SetZoom(GetZoomStep(false), get_allocated_width() / 2.0,
+          get_allocated_height() / 2.0);
+}
+
+void MineField::ZoomToFit() {
+  SetZoom(0, get_allocated_width() / 2.0, get_allocated_height() / 2.0);
+}
 
 void MineField::NotifyEventSubscription(Game* game) {
   rows_ = game->GetRows();
   cols_ = game->GetCols();
   grid_.Reset(rows_, cols_);
 
-  const int min_width = kCellSize * cols_ + 2 * kFrameSize;
-  const int min_height = kCellSize * rows_ + 2 * kFrameSize;
+  const int min_width =
+      std::min(kCellSize * cols_ + 2 * kFrameSize, kMaxSizeRequest);
+  const int min_height =
+      std::min(kCellSize * rows_ + 2 * kFrameSize, kMaxSizeRequest);
 
   set_size_request(min_width, min_height);
 
-  UpdateDrawingDimensions(std::max(min_width, get_allocated_width()),
-                          std::max(min_height, get_allocated_height()));
-  UpdatePixbufs();
+  // The widget may not have been allocated its requested size yet.
+  const int width = std::max(min_width, get_allocated_width());
+  const int height = std::max(min_height, get_allocated_height());
+  UpdateDrawingDimensions(width, height);
+  UpdateCellAtlas();
+  UpdateBackingSurface();
+  backing_valid_ = false;
+  color_map_.reset();
+  color_map_valid_ = false;
+
+  view_x_ = 0;
+  view_y_ = 0;
+  UpdateScrollbars(width, height);
 
   mouse_state_ = MouseState();
   clicked_cell_ = CellRef::None();
 
-  event_queue_ = std::queue<Event>();
-
-  timeout_connection_.disconnect();
+  CancelTick();
+  dirty_.Reset(rows_);
 
   queue_draw();
 
@@ -313,63 +120,57 @@ void MineField::NotifyEvent(const Event& event) {
     HandleEvent(event);
   } else {
     event_queue_.push(event);
-
-    if (!timeout_connection_) {
-      // Handle the rest of the events on a timeout.
-      timeout_connection_ = Glib::signal_timeout().connect(
-          sigc::mem_fun(this, &MineField::HandleEventFromQueue),
-          kEventTimeoutMs);
-    }
+    ScheduleTick();
   }
 }
 
 void MineField::on_size_allocate(Gtk::Allocation& allocation) {
   Gtk::DrawingArea::on_size_allocate(allocation);
   UpdateDrawingDimensions(allocation.get_width(), allocation.get_height());
-  UpdatePixbufs();
+  UpdateCellAtlas();
+  UpdateBackingSurface();
+  UpdateScrollbars(allocation.get_width(), allocation.get_height());
 }
 
 bool MineField::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
-  // We start by computing the top left (min) and bottom right (max) cell that
-  // will need to be drawn.
-  double clip_x;
-  double clip_y;
-  double clip_width;
-  double clip_height;
-  cr->get_clip_extents(clip_x, clip_y, clip_width, clip_height);
-
-  CellRef min_cell = GetCellRefFromPoint(clip_x, clip_y);
-  if (min_cell.cell == nullptr) {
-    min_cell = CellRef{nullptr, 0, 0};
-  }
-
-  CellRef max_cell = GetCellRefFromPoint(clip_width - 1.0, clip_height - 1.0);
-  if (max_cell.cell == nullptr) {
-    max_cell = CellRef{nullptr, rows_ - 1, cols_ - 1};
+  // Nothing to draw until subscribed to a game.
+  if (rows_ == 0) {
+    return false;
   }
 
-  // Defaults for drawing lines.
-  cr->set_line_width(1);
-  cr->set_line_cap(Cairo::LINE_CAP_SQUARE);
-
-  cr->save();
-  cr->translate(dim_.x, dim_.y);
-  DrawFrame(cr);
-  cr->restore();
+  cr->translate(-view_x_, -view_y_);
 
-  for (std::size_t row = min_cell.row; row <= max_cell.row; ++row) {
-    for (std::size_t col = min_cell.col; col <= max_cell.col; ++col) {
-      cr->save();
-      cr->translate(GetCellX(col), GetCellY(row));
-
-      CellDrawFlyweight flyweight(cr, dim_, pixbufs_, grid_(row, col), row,
-                                  col);
-      flyweight.Draw();
+  if (IsColorMapMode()) {
+    if (!color_map_valid_) {
+      RedrawColorMap();
+    }
+    detail::DrawColorMapField(cr, dim_, *color_map_);
+    return false;
+  }
 
-      cr->restore();
+  if (backing_) {
+    if (!backing_valid_) {
+      RedrawBacking();
     }
+    // Cairo limits this to the clip region.
+    cr->set_source(backing_, dim_.x, dim_.y);
+    cr->rectangle(dim_.x, dim_.y, dim_.width, dim_.height);
+    cr->fill();
+    return false;
   }
 
+  // Only the cells within the clip region, which is limited to the visible
+  // part of the widget, are drawn.
+  double clip_x1;
+  double clip_y1;
+  double clip_x2;
+  double clip_y2;
+  cr->get_clip_extents(clip_x1, clip_y1, clip_x2, clip_y2);
+  const CellRegion cells = GetCellsInArea(clip_x1, clip_y1, clip_x2, clip_y2);
+
+  detail::DrawMineField(cr, dim_, *atlas_, grid_, cells.min_row,
+                        cells.max_row, cells.min_col, cells.max_col);
+
   return false;
 }
 
@@ -467,7 +268,37 @@ bool MineField::on_button_release_event(GdkEventButton* event) {
   return false;
 }
 
+bool MineField::on_scroll_event(GdkEventScroll* event) {
+  // Smooth scrolling events are not requested.
+  if (event->direction == GDK_SCROLL_SMOOTH) {
+    return false;
+  }
+  const bool up = event->direction == GDK_SCROLL_UP;
+  const bool down = event->direction == GDK_SCROLL_DOWN;
+  if ((event->state & GDK_CONTROL_MASK) != 0) {
+    if (up || down) {
+      SetZoom(GetZoomStep(up), event->x, event->y);
+    }
+    return true;
+  }
+
+  // The shift key turns vertical scrolling horizontal.
+  const bool horizontal = event->direction == GDK_SCROLL_LEFT ||
+                          event->direction == GDK_SCROLL_RIGHT ||
+                          (event->state & GDK_SHIFT_MASK) != 0;
+  const bool back = up || event->direction == GDK_SCROLL_LEFT;
+  Glib::RefPtr<Gtk::Adjustment> adjustment =
+      (horizontal ? hscrollbar_ : vscrollbar_)->get_adjustment();
+  const double delta = kWheelSteps * adjustment->get_step_increment();
+  // The adjustment clamps the value to the mine field.
+  adjustment->set_value(adjustment->get_value() + (back ? -delta : delta));
+  return true;
+}
+
 MineField::CellRef MineField::GetCellRefFromPoint(int x, int y) {
+  // Convert to mine field coordinates.
+  x += view_x_;
+  y += view_y_;
   if (x < 0 || y < 0) {
     return CellRef::None();
   }
@@ -487,91 +318,261 @@ MineField::CellRef MineField::GetCellRefFromPoint(int x, int y) {
   return CellRef{&grid_(row, col), row, col};
 }
 
+CellRegion MineField::GetCellsInArea(double x1, double y1, double x2,
+                                     double y2) const {
+  // Converts a distance in pixels from the first cell to a cell index.
+  auto to_cell = [this](double distance, std::size_t count) {
+    if (distance <= 0.0) {
+      return std::size_t{0};
+    }
+    return std::min(static_cast<std::size_t>(distance / dim_.cell_size),
+                    count - 1);
+  };
+  const double x0 = GetCellX(0);
+  const double y0 = GetCellY(0);
+  CellRegion region(to_cell(y1 - y0, rows_), to_cell(x1 - x0, cols_));
+  region.Include(to_cell(y2 - 1.0 - y0, rows_), to_cell(x2 - 1.0 - x0, cols_));
+  return region;
+}
+
 std::size_t MineField::GetCellX(std::size_t col) const {
-  return dim_.x + kFrameSize + col * dim_.cell_size;
+  return dim_.GetCellX(col);
 }
 
 std::size_t MineField::GetCellY(std::size_t row) const {
-  return dim_.y + kFrameSize + row * dim_.cell_size;
+  return dim_.GetCellY(row);
 }
 
 void MineField::QueueDrawCell(std::size_t row, std::size_t col) {
-  queue_draw_area(GetCellX(col), GetCellY(row), dim_.cell_size, dim_.cell_size);
+  DrawBackingCell(row, col);
+  dirty_.Include(row, col);
+  ScheduleTick();
 }
 
 void MineField::QueueDrawCellRegion(const CellRegion& region) {
-  queue_draw_area(GetCellX(region.min_col), GetCellY(region.min_row),
-                  (region.max_col - region.min_col + 1) * dim_.cell_size,
-                  (region.max_row - region.min_row + 1) * dim_.cell_size);
+  for (std::size_t row = region.min_row; row <= region.max_row; ++row) {
+    for (std::size_t col = region.min_col; col <= region.max_col; ++col) {
+      DrawBackingCell(row, col);
+    }
+  }
+  dirty_.Include(region);
+  ScheduleTick();
+}
+
+void MineField::FlushDirtyRegion() {
+  if (dirty_.IsEmpty()) {
+    return;
+  }
+  for (const CellRegion& region : dirty_.Flush()) {
+    queue_draw_area(static_cast<int>(GetCellX(region.min_col)) - view_x_,
+                    static_cast<int>(GetCellY(region.min_row)) - view_y_,
+                    (region.max_col - region.min_col + 1) * dim_.cell_size,
+                    (region.max_row - region.min_row + 1) * dim_.cell_size);
+  }
 }
 
 void MineField::UpdateDrawingDimensions(int width, int height) {
-  dim_.cell_size = std::min((width - 2 * kFrameSize) / cols_,
-                            (height - 2 * kFrameSize) / rows_);
-  dim_.width = dim_.cell_size * cols_ + 2 * kFrameSize;
-  dim_.height = dim_.cell_size * rows_ + 2 * kFrameSize;
+  const std::size_t frame = 2 * kFrameSize;
+  const std::size_t uwidth = std::max<int>(width, frame);
+  const std::size_t uheight = std::max<int>(height, frame);
+  const std::size_t fit_size =
+      std::min((uwidth - frame) / cols_, (uheight - frame) / rows_);
+  dim_.cell_size = zoom_ != 0 ? zoom_ : std::max<std::size_t>(fit_size, 1);
+  dim_.width = dim_.cell_size * cols_ + frame;
+  dim_.height = dim_.cell_size * rows_ + frame;
 
   // Center the part of the drawing area we are actually using within the
-  // total available space.
-  dim_.x = width / 2 - dim_.width / 2;
-  dim_.y = height / 2 - dim_.height / 2;
+  // total available space. A mine field larger than the space starts at the
+  // origin and is scrolled instead.
+  dim_.x = dim_.width < uwidth ? uwidth / 2 - dim_.width / 2 : 0;
+  dim_.y = dim_.height < uheight ? uheight / 2 - dim_.height / 2 : 0;
+}
+
+void MineField::UpdateCellAtlas() {
+  // The color map is used instead of the atlas for small cells, and resizing
+  // the window does not always change the cell size.
+  if (IsColorMapMode() ||
+      (atlas_ != nullptr && atlas_->GetCellSize() == dim_.cell_size)) {
+    return;
+  }
+  atlas_ = MakeUnique<detail::CellAtlas>(dim_.cell_size,
+                                         detail::LoadPixbufs(dim_.cell_size));
+  backing_valid_ = false;
+}
+
+void MineField::UpdateScrollbars(int width, int height) {
+  const int field_width = dim_.width;
+  const int field_height = dim_.height;
+
+  // Configuring the adjustments clamps the view, and each scrollbar only
+  // appears when the mine field does not fit. Adding a scrollbar can only
+  // shrink the widget, and removing one can only grow it, so showing them
+  // here cannot cause the layout to oscillate.
+  //
+  // Configuring the first adjustment calls OnScrollbarChanged, which reads the
+  // second before it is configured, so the view is saved first.
+  const int view_x = view_x_;
+  const int view_y = view_y_;
+  hscrollbar_->get_adjustment()->configure(
+      view_x, 0, std::max(field_width, width), dim_.cell_size, width * 0.9,
+      width);
+  vscrollbar_->get_adjustment()->configure(
+      view_y, 0, std::max(field_height, height), dim_.cell_size,
+      height * 0.9, height);
+  hscrollbar_->set_visible(field_width > width);
+  vscrollbar_->set_visible(field_height > height);
+  OnScrollbarChanged();
+}
+
+void MineField::OnScrollbarChanged() {
+  const int view_x =
+      static_cast<int>(hscrollbar_->get_adjustment()->get_value());
+  const int view_y =
+      static_cast<int>(vscrollbar_->get_adjustment()->get_value());
+  if (view_x != view_x_ || view_y != view_y_) {
+    view_x_ = view_x;
+    view_y_ = view_y;
+    queue_draw();
+  }
 }
 
-Glib::RefPtr<Gdk::Pixbuf> MineField::LoadPixbuf(
-    const char* resource_path) const {
-  return compat::CreatePixbufFromResource(resource_path, 0.7 * dim_.cell_size,
-                                          0.7 * dim_.cell_size);
+void MineField::SetZoom(std::size_t cell_size, double x, double y) {
+  if (rows_ == 0) {
+    return;
+  }
+
+  // The position under (x, y), in cells from the top left cell.
+  const double cell_x = (x + view_x_ - GetCellX(0)) / dim_.cell_size;
+  const double cell_y = (y + view_y_ - GetCellY(0)) / dim_.cell_size;
+
+  const int width = get_allocated_width();
+  const int height = get_allocated_height();
+  zoom_ = cell_size;
+  UpdateDrawingDimensions(width, height);
+  view_x_ = static_cast<int>(GetCellX(0) + cell_x * dim_.cell_size - x);
+  view_y_ = static_cast<int>(GetCellY(0) + cell_y * dim_.cell_size - y);
+
+  UpdateCellAtlas();
+  UpdateBackingSurface();
+  UpdateScrollbars(width, height);
+  queue_draw();
 }
 
-void MineField::UpdatePixbufs() {
-  pixbufs_.mine = LoadPixbuf(kMineResourcePath);
-  pixbufs_.flag = LoadPixbuf(kFlagResourcePath);
+std::size_t MineField::GetZoomStep(bool in) const {
+  std::size_t step = dim_.cell_size;
+  for (const std::size_t level : kZoomLevels) {
+    if (in && level > dim_.cell_size) {
+      return level;
+    }
+    if (!in && level < dim_.cell_size) {
+      step = level;
+    }
+  }
+  return step;
 }
 
-void MineField::DrawFrame(const Cairo::RefPtr<Cairo::Context>& cr) {
-  SetColor(cr, kFrameColor);
-  cr->rectangle(0.0, 0.0, dim_.width, kFrameSize);
-  cr->rectangle(0.0, 0.0, kFrameSize, dim_.height);
-  cr->rectangle(0.0, dim_.height - kFrameSize, dim_.width, kFrameSize);
-  cr->rectangle(dim_.width - kFrameSize, 0.0, kFrameSize, dim_.height);
-  cr->fill();
+void MineField::DrawBackingCell(std::size_t row, std::size_t col) {
+  if (color_map_valid_) {
+    color_map_->Draw(grid_(row, col), row, col);
+  }
+  if (!backing_ || !backing_valid_) {
+    return;
+  }
+  // The backing surface has the frame at the origin.
+  atlas_->Draw(backing_cr_, grid_(row, col), row, col,
+               dim_.GetCellX(col) - dim_.x, dim_.GetCellY(row) - dim_.y);
 }
 
-bool MineField::HandleEventFromQueue() {
-  // Handle 3 events at a time because 1ms is too slow for the timer but
-  // there is no way to set a submillisecond timer.
-  for (std::size_t i = 0; i < 3 && !event_queue_.empty(); ++i) {
+void MineField::RedrawBacking() {
+  detail::DrawingDimensions dim = dim_;
+  dim.x = 0;
+  dim.y = 0;
+  detail::DrawMineField(backing_cr_, dim, *atlas_, grid_, 0, rows_ - 1, 0,
+                        cols_ - 1);
+  backing_valid_ = true;
+}
+
+void MineField::RedrawColorMap() {
+  if (color_map_ == nullptr) {
+    color_map_ = MakeUnique<detail::CellColorMap>(rows_, cols_);
+  }
+  grid_.ForEach([this](std::size_t row, std::size_t col, Cell& cell) {
+    color_map_->Draw(cell, row, col);
+  });
+  color_map_valid_ = true;
+}
+
+bool MineField::IsColorMapMode() const {
+  return dim_.cell_size < kMinDetailCellSize;
+}
+
+void MineField::UpdateBackingSurface() {
+  if (backing_ && backing_->get_width() == static_cast<int>(dim_.width) &&
+      backing_->get_height() == static_cast<int>(dim_.height)) {
+    return;
+  }
+
+  backing_valid_ = false;
+  backing_ = Cairo::RefPtr<Cairo::ImageSurface>();
+  backing_cr_ = Cairo::RefPtr<Cairo::Context>();
+  if (IsColorMapMode() || dim_.width * dim_.height > kMaxBackingPixels) {
+    return;
+  }
+  backing_ = Cairo::ImageSurface::create(Cairo::FORMAT_RGB24, dim_.width,
+                                         dim_.height);
+  backing_cr_ = Cairo::Context::create(backing_);
+}
+
+void MineField::ScheduleTick() {
+  if (tick_id_ != 0) {
+    return;
+  }
+  last_frame_time_ = 0;
+  event_budget_ = 0.0;
+  tick_id_ = add_tick_callback(sigc::mem_fun(*this, &MineField::OnTick));
+}
+
+void MineField::CancelTick() {
+  if (tick_id_ != 0) {
+    remove_tick_callback(tick_id_);
+    tick_id_ = 0;
+  }
+  event_queue_ = std::queue<Event>();
+}
+
+bool MineField::OnTick(const Glib::RefPtr<Gdk::FrameClock>& frame_clock) {
+  const gint64 frame_time = frame_clock->get_frame_time();
+
+  std::size_t count = event_queue_.size();
+  if (cells_per_second_ != 0) {
+    if (last_frame_time_ != 0) {
+      event_budget_ += static_cast<double>(frame_time - last_frame_time_) *
+                       cells_per_second_ / 1e6;
+    }
+    // Always make progress, even if frames arrive faster than the rate.
+    const std::size_t budget =
+        std::max<std::size_t>(1, static_cast<std::size_t>(event_budget_));
+    count = std::min(count, budget);
+    event_budget_ = std::max(0.0, event_budget_ - count);
+  }
+  last_frame_time_ = frame_time;
+
+  for (std::size_t i = 0; i < count; ++i) {
     HandleEvent(event_queue_.front());
     event_queue_.pop();
   }
-  return !event_queue_.empty();
+  FlushDirtyRegion();
+
+  if (event_queue_.empty()) {
+    // Returning false removes the callback.
+    tick_id_ = 0;
+    return false;
+  }
+  return true;
 }
 
 void MineField::HandleEvent(const Event& event) {
-  Cell& cell = grid_(event.row, event.col);
-  switch (event.type) {
-    case Event::Type::UNCOVER:
-      cell.state = CellState::UNCOVERED;
-      cell.adjacent_mines = event.adjacent_mines;
-      break;
-    case Event::Type::FLAG:
-      cell.state = CellState::FLAGGED;
-      break;
-    case Event::Type::UNFLAG:
-      cell.state = CellState::COVERED;
-      break;
-    case Event::Type::WIN:
-      break;
-    case Event::Type::LOSS:
-      cell.state = CellState::LOSING_MINE;
-      break;
-    case Event::Type::IDENTIFY_MINE:
-      cell.state = CellState::MINE;
-      break;
-    case Event::Type::IDENTIFY_BAD_FLAG:
-      cell.state = CellState::BAD_FLAG;
-      break;
-  }
+  UpdatePlayerCell(event, &grid_(event.row, event.col));
   QueueDrawCell(event.row, event.col);
 }
 
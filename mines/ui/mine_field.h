@@ -3,58 +3,37 @@
 
 #include <array>
 #include <cstddef>
+#include <memory>
 #include <queue>
 
 #include <cairomm/context.h>
 #include <cairomm/refptr.h>
+#include <cairomm/surface.h>
+#include <gdkmm/frameclock.h>
 #include <gdkmm/pixbuf.h>
 #include <glibmm/refptr.h>
 #include <gtkmm/builder.h>
 #include <gtkmm/drawingarea.h>
-#include <sigc++/connection.h>
+#include <gtkmm/scrollbar.h>
 #include <sigc++/signal.h>
 
 #include "mines/game/game.h"
 #include "mines/game/grid.h"
+#include "mines/ui/cell_region.h"
+#include "mines/ui/mine_field_renderer.h"
 
 namespace mines {
 namespace ui {
 
-namespace detail {
-
-// The dimensions of the actual area upon which the mine field will be drawn.
-// This is a subset of the actual allocated area.
-struct DrawingDimensions {
-  std::size_t x;
-  std::size_t y;
-  std::size_t width;
-  std::size_t height;
-  std::size_t cell_size;
-};
-
-// The collection of pixbufs used in the mine field.
-struct Pixbufs {
-  Glib::RefPtr<Gdk::Pixbuf> mine;
-  Glib::RefPtr<Gdk::Pixbuf> flag;
-};
-
-// A representation of the GUI's knowledge about a cell.
-struct Cell {
-  // The state of the cell.
-  CellState state = CellState::COVERED;
-
-  // Whether the cell should be rendered as pressed by the mouse.
-  bool pressed = false;
-
-  // The number of adjacent mines.
-  std::size_t adjacent_mines = 0;
-};
-
-}  // namespace detail
-
 // A mine field widget.
 //
 // When subscribed to a game the MineField will automatically update.
+//
+// By default the cells are as large as possible while still fitting the whole
+// mine field in the widget. The mine field can be zoomed, with scrollbars for
+// viewing mine fields larger than the widget, and only the visible cells are
+// drawn. Cells too small to show their contents are drawn as a color map with
+// one pixel per cell.
 class MineField : public Gtk::DrawingArea, public EventSubscriber {
  public:
   // Gets the MineField from the builder.
@@ -70,6 +49,25 @@ class MineField : public Gtk::DrawingArea, public EventSubscriber {
   // The action type will be one of: UNCOVER, CHORD, or FLAG.
   sigc::signal<void, Action>& signal_action() { return signal_action_; }
 
+  // The default rate at which queued events are shown. A small visual delay
+  // between events gives a natural feel when areas are uncovered.
+  static constexpr std::size_t kDefaultCellsPerSecond = 3000;
+
+  // Sets the rate, in cells per second, at which queued events are shown.
+  //
+  // Zero shows every queued event on the next frame, which suits solver runs
+  // where the animation would only lag behind the game.
+  void SetAnimationRate(std::size_t cells_per_second);
+
+  // Zooms in one step, keeping the center of the view in place.
+  void ZoomIn();
+
+  // Zooms out one step, keeping the center of the view in place.
+  void ZoomOut();
+
+  // Returns to the default zoom, fitting the whole mine field in the widget.
+  void ZoomToFit();
+
  private:
   // Resets the internal state for a new game.
   void NotifyEventSubscription(Game* game) final;
@@ -92,6 +90,9 @@ class MineField : public Gtk::DrawingArea, public EventSubscriber {
   // Handles mouse button releases.
   bool on_button_release_event(GdkEventButton* event) final;
 
+  // Scrolls the view, or zooms about the pointer if the control key is held.
+  bool on_scroll_event(GdkEventScroll* event) final;
+
   // Reference to a cell and the associated row and column.
   struct CellRef {
     detail::Cell* cell;
@@ -101,31 +102,6 @@ class MineField : public Gtk::DrawingArea, public EventSubscriber {
     static CellRef None() { return {nullptr, 0, 0}; }
   };
 
-  // A rectangular region of one or more cells, represented as the location of
-  // the top left and bottom right cells.
-  struct CellRegion {
-    // Constructs a cell region containing the specified cell.
-    CellRegion(std::size_t row, std::size_t col) {
-      min_row = row;
-      max_row = row;
-      min_col = col;
-      max_col = col;
-    }
-
-    // Ensures that the specified cell is included in the region.
-    void Include(std::size_t row, std::size_t col) {
-      min_row = std::min(row, min_row);
-      max_row = std::max(row, max_row);
-      min_col = std::min(col, min_col);
-      max_col = std::max(col, max_col);
-    }
-
-    std::size_t min_row;
-    std::size_t max_row;
-    std::size_t min_col;
-    std::size_t max_col;
-  };
-
   // The state of the mouse.
   struct MouseState {
     static constexpr std::size_t kMaxButton = 3;
@@ -139,39 +115,84 @@ class MineField : public Gtk::DrawingArea, public EventSubscriber {
   // Computes the cell from mouse event coordinates.
   CellRef GetCellRefFromPoint(int x, int y);
 
+  // Computes the cells overlapping an area in mine field coordinates, clamped
+  // to the mine field.
+  detail::CellRegion GetCellsInArea(double x1, double y1, double x2,
+                                    double y2) const;
+
   // Computes the x coordinate, in pixels, of cells in the specified column.
   std::size_t GetCellX(std::size_t col) const;
 
   // Computes the y coordinate, in pixels, of cells in the specified row.
   std::size_t GetCellY(std::size_t row) const;
 
-  // Requests a redraw clipped to the specified cell.
+  // Redraws the specified cell into the backing surface and marks it to be
+  // copied to the window on the next frame.
   void QueueDrawCell(std::size_t row, std::size_t col);
 
-  // Requests a redraw clipped to the specified cell region.
-  void QueueDrawCellRegion(const CellRegion& region);
+  // Redraws the specified cell region into the backing surface and marks it
+  // to be copied to the window on the next frame.
+  void QueueDrawCellRegion(const detail::CellRegion& region);
+
+  // Draws a single cell into the backing surface and color map, unless they
+  // are awaiting a full redraw.
+  void DrawBackingCell(std::size_t row, std::size_t col);
+
+  // Draws the entire mine field into the backing surface.
+  void RedrawBacking();
+
+  // Draws every cell into the color map, creating it if necessary.
+  void RedrawColorMap();
+
+  // Returns true if cells are too small to show their contents, in which case
+  // the mine field is drawn from the color map.
+  bool IsColorMapMode() const;
+
+  // Recreates the backing surface if the drawing dimensions have changed.
+  void UpdateBackingSurface();
 
   // Recomputes the drawing dimensions.
   void UpdateDrawingDimensions(int width, int height);
 
-  // Loads a pixbuf from a resource path at current cell dimensions.
-  Glib::RefPtr<Gdk::Pixbuf> LoadPixbuf(const char* resource_path) const;
+  // Rebuilds the cell atlas if the cell size has changed.
+  void UpdateCellAtlas();
 
-  // Reload all pixbufs at current cell dimensions.
-  void UpdatePixbufs();
+  // Updates the scrollbars to match the drawing dimensions and the size of the
+  // widget, clamping the view to the mine field. Each scrollbar is only shown
+  // if the mine field does not fit in that direction.
+  void UpdateScrollbars(int width, int height);
 
-  // Draws the frame surrounding the mine field.
-  void DrawFrame(const Cairo::RefPtr<Cairo::Context>& cr);
+  // Handles a change in the position of either scrollbar.
+  void OnScrollbarChanged();
 
-  // Updates the visual state based on the top several events in the event
-  // queue.
+  // Changes the cell size, keeping the point (x, y) of the widget over the
+  // same part of the mine field. A cell size of zero fits the mine field to the
+  // widget.
+  void SetZoom(std::size_t cell_size, double x, double y);
+
+  // Returns the next cell size larger than the current one if in is true, or
+  // smaller otherwise. Returns the current cell size if there is none.
+  std::size_t GetZoomStep(bool in) const;
+
+  // Ensures that OnTick runs on the next frame.
+  void ScheduleTick();
+
+  // Removes the tick callback and discards any queued events.
+  void CancelTick();
+
+  // Handles as many queued events as the animation rate allows for the time
+  // since the previous frame, then requests a redraw of the dirty cells.
   //
   // Returns true if there are more events to handle.
-  bool HandleEventFromQueue();
+  bool OnTick(const Glib::RefPtr<Gdk::FrameClock>& frame_clock);
 
   // Updates the visual state based on the event.
   void HandleEvent(const Event& event);
 
+  // Requests that the dirty cells be copied to the window, as a few merged
+  // rectangles.
+  void FlushDirtyRegion();
+
   // Returns true if the specified row and column are in or adjacent to the
   // last clicked cell.
   bool IsAdjacentToClickedCell(std::size_t row, std::size_t col) const;
@@ -184,10 +205,41 @@ class MineField : public Gtk::DrawingArea, public EventSubscriber {
   Grid<detail::Cell> grid_;
 
   // Drawing dimensions, updated each time a "configure-event" signal is sent.
+  // These are in mine field coordinates, which differ from widget coordinates
+  // by the view position.
   detail::DrawingDimensions dim_;
 
-  // Pixbufs necessary to draw the mine field.
-  detail::Pixbufs pixbufs_;
+  // The cell size chosen by zooming, or zero to fit the mine field to the
+  // widget.
+  std::size_t zoom_ = 0;
+
+  // The position of the top left of the widget in mine field coordinates.
+  // Non-zero only when the mine field is larger than the widget.
+  int view_x_ = 0;
+  int view_y_ = 0;
+
+  // Scrollbars for viewing mine fields larger than the widget.
+  Gtk::Scrollbar* hscrollbar_ = nullptr;
+  Gtk::Scrollbar* vscrollbar_ = nullptr;
+
+  // Pre-rendered cell images at the current cell size.
+  std::unique_ptr<detail::CellAtlas> atlas_;
+
+  // A copy of the whole mine field, drawn with its frame at the origin. Cells
+  // are redrawn into it as they change, so an expose only has to copy the
+  // clip region to the window. Null if the board is too large to keep a copy
+  // of, in which case cells are drawn directly.
+  Cairo::RefPtr<Cairo::ImageSurface> backing_;
+  Cairo::RefPtr<Cairo::Context> backing_cr_;
+
+  // False if the backing surface must be redrawn in full before it is used.
+  bool backing_valid_ = false;
+
+  // The mine field with one pixel per cell, created the first time cells are
+  // too small to draw individually. Once valid it is kept up to date at any
+  // cell size, since updating a pixel costs little.
+  std::unique_ptr<detail::CellColorMap> color_map_;
+  bool color_map_valid_ = false;
 
   // Mouse event state tracking.
   MouseState mouse_state_;
@@ -195,11 +247,28 @@ class MineField : public Gtk::DrawingArea, public EventSubscriber {
   // The most recently clicked cell.
   CellRef clicked_cell_;
 
+  // Cells changed since the last frame that have not been copied to the
+  // window.
+  detail::DirtyRegion dirty_;
+
   // Queue of events that still need to be handled.
   std::queue<Event> event_queue_;
 
-  // Connection to the timeout signal.
-  sigc::connection timeout_connection_;
+  // The number of queued events handled per second. Zero means all of them
+  // are handled on the next frame.
+  std::size_t cells_per_second_;
+
+  // The tick callback handling queued events and dirty cells, or zero if
+  // there is none.
+  guint tick_id_ = 0;
+
+  // The frame time, in microseconds, of the previous tick. Zero before the
+  // first tick of an animation.
+  gint64 last_frame_time_ = 0;
+
+  // Fractional events carried over between frames, so that rates which are
+  // not a multiple of the frame rate are honoured on average.
+  double event_budget_ = 0.0;
 
   // Signal emitted when an action occurs.
   sigc::signal<void, Action> signal_action_;
@@ -0,0 +1,491 @@
+#include "mines/ui/mine_field_renderer.h"
+
+#include <algorithm>
+#include <array>
+
+#include <cairomm/enums.h>
+#include <cairomm/pattern.h>
+#include <cairomm/types.h>
+#include <gdkmm/general.h>
+
+#include "mines/ui/pixbuf_cache.h"
+
+namespace mines {
+namespace ui {
+namespace detail {
+
+namespace {
+
+// Resource path for the mine graphic.
+constexpr const char* kMineResourcePath = "/com/alanwj/mines-solver/mine.svg";
+
+// Resource path for the flag graphic.
+constexpr const char* kFlagResourcePath = "/com/alanwj/mines-solver/flag.svg";
+
+// The rows of the cell atlas. Uncovered cells follow kAtlasUncovered in order
+// of their number of adjacent mines.
+enum AtlasRow : std::size_t {
+  kAtlasCovered,
+  kAtlasPressed,
+  kAtlasFlagged,
+  kAtlasBadFlag,
+  kAtlasMine,
+  kAtlasLosingMine,
+  kAtlasUncovered,
+  kAtlasRows = kAtlasUncovered + 9,
+};
+
+// Encapsulates a simple RGB color.
+struct Color {
+  double r;
+  double g;
+  double b;
+};
+
+// The color to use for numbers 1 through 8.
+constexpr std::array<Color, 8> kNumberColor{{
+    {0.0, 0.0, 1.0},  // 1
+    {0.0, 0.5, 0.0},  // 2
+    {1.0, 0.0, 0.0},  // 3
+    {0.0, 0.0, 0.5},  // 4
+    {0.5, 0.0, 0.0},  // 5
+    {0.0, 0.5, 0.5},  // 6
+    {0.5, 0.0, 0.5},  // 7
+    {0.0, 0.0, 0.0},  // 8
+}};
+
+// Colors used in widget construction.
+constexpr Color kFrameColor{0.5, 0.5, 0.5};
+constexpr Color kCellColor{0.76, 0.76, 0.76};
+constexpr Color kLosingMineCellColor{1.0, 0.0, 0.0};
+constexpr Color kCellBorderColor{0.5, 0.5, 0.5};
+constexpr Color kLightBevelColor{1.0, 1.0, 1.0};
+constexpr Color kDarkBevelColor{0.5, 0.5, 0.5};
+
+// Colors used only in the color map, where cells are too small for numbers or
+// pixbufs.
+constexpr Color kEmptyColorMapColor{1.0, 1.0, 1.0};
+constexpr Color kFlagColorMapColor{1.0, 0.5, 0.0};
+constexpr Color kBadFlagColorMapColor{1.0, 0.0, 1.0};
+constexpr Color kMineColorMapColor{0.0, 0.0, 0.0};
+
+// Sets the source color in the specified context.
+void SetColor(const Cairo::RefPtr<Cairo::Context>& cr, const Color& color) {
+  cr->set_source_rgb(color.r, color.g, color.b);
+}
+
+// A flyweight class to encapsulate the process of drawing a cell.
+//
+// This exists primarily to separate this drawing logic from the MineField class
+// to prevent it from growing too complex.
+class CellDrawFlyweight {
+ public:
+  CellDrawFlyweight(const Cairo::RefPtr<Cairo::Context>& cr,
+                    const DrawingDimensions& dim, const Pixbufs& pixbufs,
+                    const Cell& cell, std::size_t row, std::size_t col)
+      : cr_(cr),
+        dim_(dim),
+        pixbufs_(pixbufs),
+        cell_(cell),
+        row_(row),
+        col_(col) {}
+
+  CellDrawFlyweight(const CellDrawFlyweight&) = delete;
+  CellDrawFlyweight& operator=(const CellDrawFlyweight&) = delete;
+  CellDrawFlyweight(CellDrawFlyweight&&) = delete;
+  CellDrawFlyweight& operator=(CellDrawFlyweight&&) = delete;
+
+  void Draw() const {
+    switch (cell_.state) {
+      case CellState::UNCOVERED:
+        DrawUncovered();
+        break;
+      case CellState::COVERED:
+        if (cell_.pressed) {
+          DrawPressed();
+        } else {
+          DrawCovered();
+        }
+        break;
+      case CellState::FLAGGED:
+        DrawFlagged();
+        break;
+      case CellState::MINE:
+        DrawMine();
+        break;
+      case CellState::LOSING_MINE:
+        DrawLosingMine();
+        break;
+      case CellState::BAD_FLAG:
+        DrawBadFlag();
+        break;
+    };
+  }
+
+ private:
+  // Fills the cell with the specified color.
+  void FillCell(const Color& color) const {
+    SetColor(cr_, color);
+    cr_->rectangle(0.0, 0.0, dim_.cell_size, dim_.cell_size);
+    cr_->fill();
+  }
+
+  // Draws a sharp single pixel horizontal line of the specified width.
+  void DrawHLine(std::size_t x, std::size_t y, std::size_t width) const {
+    cr_->save();
+    cr_->translate(0.5, 0.5);
+    cr_->move_to(x, y);
+    cr_->line_to(x + width - 1, y);
+    cr_->restore();
+  }
+
+  // Draws a sharp single pixel vertical line of the specified height.
+  void DrawVLine(std::size_t x, std::size_t y, std::size_t height) const {
+    cr_->save();
+    cr_->translate(0.5, 0.5);
+    cr_->move_to(x, y);
+    cr_->line_to(x, y + height - 1);
+    cr_->restore();
+  }
+
+  // Draws a character in a cell.
+  void DrawChar(char c) const {
+    const char str[2] = {c, '\0'};
+
+    cr_->select_font_face("cairo:monospace", Cairo::FONT_SLANT_NORMAL,
+                          Cairo::FONT_WEIGHT_BOLD);
+    // Empirically, 9/10 of the cell looks pretty good.
+    cr_->set_font_size(.9 * dim_.cell_size);
+    Cairo::TextExtents te;
+    cr_->get_text_extents(str, te);
+
+    cr_->move_to(dim_.cell_size / 2 - te.width / 2 - te.x_bearing,
+                 dim_.cell_size / 2 - te.height / 2 - te.y_bearing);
+    cr_->show_text(str);
+  }
+
+  // Draws an empty cell.
+  void DrawEmpty(const Color& color) const {
+    FillCell(color);
+    SetColor(cr_, kCellBorderColor);
+    if (row_ != 0) {
+      DrawHLine(0, 0, dim_.cell_size);
+    }
+    if (col_ != 0) {
+      DrawVLine(0, 0, dim_.cell_size);
+    }
+    cr_->stroke();
+  }
+
+  // Draws a cell in the UNCOVERED state with the number of adjacent mines.
+  void DrawUncovered() const {
+    DrawEmpty(kCellColor);
+    if (cell_.adjacent_mines > 0 && cell_.adjacent_mines <= 8) {
+      SetColor(cr_, kNumberColor[cell_.adjacent_mines - 1]);
+      DrawChar('0' + cell_.adjacent_mines);
+    }
+  }
+
+  // Draws a cell that is visually pressed by a mouse action.
+  void DrawPressed() const {
+    FillCell(kCellColor);
+    SetColor(cr_, kDarkBevelColor);
+    DrawHLine(0, 0, dim_.cell_size);
+    DrawVLine(0, 0, dim_.cell_size);
+    cr_->stroke();
+  }
+
+  // Draws a cell in the COVERED state.
+  void DrawCovered() const {
+    FillCell(kCellColor);
+
+    // Light bevel on top.
+    SetColor(cr_, kLightBevelColor);
+    DrawHLine(0, 0, dim_.cell_size - 1);
+    DrawHLine(0, 1, dim_.cell_size - 2);
+
+    // Light bevel on left.
+    DrawVLine(0, 0, dim_.cell_size - 1);
+    DrawVLine(1, 0, dim_.cell_size - 2);
+    cr_->stroke();
+
+    // Dark bevel on bottom.
+    SetColor(cr_, kDarkBevelColor);
+    DrawHLine(1, dim_.cell_size - 1, dim_.cell_size - 1);
+    DrawHLine(2, dim_.cell_size - 2, dim_.cell_size - 2);
+
+    // Dark bevel on right.
+    DrawVLine(dim_.cell_size - 1, 1, dim_.cell_size - 1);
+    DrawVLine(dim_.cell_size - 2, 2, dim_.cell_size - 2);
+    cr_->stroke();
+  }
+
+  // Draws the provided pixbuf in the center of the cell.
+  void DrawPixbuf(const Glib::RefPtr<Gdk::Pixbuf>& pixbuf) const {
+    cr_->save();
+    Gdk::Cairo::set_source_pixbuf(
+        cr_, pixbuf, dim_.cell_size / 2 - pixbuf->get_width() / 2,
+        dim_.cell_size / 2 - pixbuf->get_height() / 2);
+    cr_->paint();
+    cr_->restore();
+  }
+
+  // Draws a cell in the FLAGGED state.
+  void DrawFlagged() const {
+    DrawCovered();
+    DrawPixbuf(pixbufs_.flag);
+  }
+
+  // Draws a cell in the MINE state.
+  void DrawMine() const {
+    DrawEmpty(kCellColor);
+    DrawPixbuf(pixbufs_.mine);
+  }
+
+  // Draws a cell in the LOSING_MINE state.
+  void DrawLosingMine() const {
+    DrawEmpty(kLosingMineCellColor);
+    DrawPixbuf(pixbufs_.mine);
+  }
+
+  // Draws a cell in the BAD_FLAG state.
+  void DrawBadFlag() const {
+    DrawFlagged();
+    cr_->save();
+    SetColor(cr_, {1.0, 0.0, 0.0});
+    cr_->scale(dim_.cell_size, dim_.cell_size);
+    cr_->set_line_width(.15);
+    cr_->set_line_cap(Cairo::LINE_CAP_ROUND);
+
+    const double margin = .15;
+    cr_->move_to(margin, margin);
+    cr_->line_to(1.0 - margin, 1.0 - margin);
+    cr_->move_to(margin, 1.0 - margin);
+    cr_->line_to(1.0 - margin, margin);
+    cr_->stroke();
+
+    cr_->restore();
+  }
+
+  const Cairo::RefPtr<Cairo::Context>& cr_;
+  const DrawingDimensions& dim_;
+  const Pixbufs& pixbufs_;
+  const Cell& cell_;
+  const std::size_t row_;
+  const std::size_t col_;
+};
+
+// Loads a pixbuf from a resource path for the specified cell size.
+Glib::RefPtr<Gdk::Pixbuf> LoadPixbuf(const char* resource_path,
+                                     std::size_t cell_size) {
+  return GetCachedPixbuf(resource_path, 0.7 * cell_size, 0.7 * cell_size);
+}
+
+// Draws the frame surrounding the mine field.
+void DrawFrame(const Cairo::RefPtr<Cairo::Context>& cr,
+               const DrawingDimensions& dim) {
+  SetColor(cr, kFrameColor);
+  cr->rectangle(0.0, 0.0, dim.width, kFrameSize);
+  cr->rectangle(0.0, 0.0, kFrameSize, dim.height);
+  cr->rectangle(0.0, dim.height - kFrameSize, dim.width, kFrameSize);
+  cr->rectangle(dim.width - kFrameSize, 0.0, kFrameSize, dim.height);
+  cr->fill();
+}
+
+// Returns a cell with the appearance of the specified atlas row.
+Cell GetAtlasCell(std::size_t atlas_row) {
+  Cell cell;
+  switch (atlas_row) {
+    case kAtlasCovered:
+      cell.state = CellState::COVERED;
+      break;
+    case kAtlasPressed:
+      cell.state = CellState::COVERED;
+      cell.pressed = true;
+      break;
+    case kAtlasFlagged:
+      cell.state = CellState::FLAGGED;
+      break;
+    case kAtlasBadFlag:
+      cell.state = CellState::BAD_FLAG;
+      break;
+    case kAtlasMine:
+      cell.state = CellState::MINE;
+      break;
+    case kAtlasLosingMine:
+      cell.state = CellState::LOSING_MINE;
+      break;
+    default:
+      cell.state = CellState::UNCOVERED;
+      cell.adjacent_mines = atlas_row - kAtlasUncovered;
+      break;
+  }
+  return cell;
+}
+
+// Returns the atlas row holding the appearance of the cell.
+std::size_t GetAppearance(const Cell& cell) {
+  switch (cell.state) {
+    case CellState::UNCOVERED:
+      return kAtlasUncovered + std::min<std::size_t>(cell.adjacent_mines, 8);
+    case CellState::COVERED:
+      return cell.pressed ? kAtlasPressed : kAtlasCovered;
+    case CellState::FLAGGED:
+      return kAtlasFlagged;
+    case CellState::MINE:
+      return kAtlasMine;
+    case CellState::LOSING_MINE:
+      return kAtlasLosingMine;
+    case CellState::BAD_FLAG:
+      return kAtlasBadFlag;
+  }
+  return kAtlasCovered;
+}
+
+// Returns the color map color of the specified atlas row.
+Color GetColorMapColor(std::size_t atlas_row) {
+  switch (atlas_row) {
+    case kAtlasCovered:
+      return kCellColor;
+    case kAtlasPressed:
+      return kDarkBevelColor;
+    case kAtlasFlagged:
+      return kFlagColorMapColor;
+    case kAtlasBadFlag:
+      return kBadFlagColorMapColor;
+    case kAtlasMine:
+      return kMineColorMapColor;
+    case kAtlasLosingMine:
+      return kLosingMineCellColor;
+    case kAtlasUncovered:
+      return kEmptyColorMapColor;
+    default:
+      return kNumberColor[atlas_row - kAtlasUncovered - 1];
+  }
+}
+
+// Converts a color to a FORMAT_RGB24 pixel.
+std::uint32_t ToPixel(const Color& color) {
+  return static_cast<std::uint32_t>(color.r * 255.0 + 0.5) << 16 |
+         static_cast<std::uint32_t>(color.g * 255.0 + 0.5) << 8 |
+         static_cast<std::uint32_t>(color.b * 255.0 + 0.5);
+}
+
+}  // namespace
+
+Pixbufs LoadPixbufs(std::size_t cell_size) {
+  Pixbufs pixbufs;
+  pixbufs.mine = LoadPixbuf(kMineResourcePath, cell_size);
+  pixbufs.flag = LoadPixbuf(kFlagResourcePath, cell_size);
+  return pixbufs;
+}
+
+constexpr std::size_t CellAtlas::kEdgeVariants;
+
+CellAtlas::CellAtlas(std::size_t cell_size, const Pixbufs& pixbufs)
+    : cell_size_(cell_size),
+      surface_(Cairo::ImageSurface::create(Cairo::FORMAT_RGB24,
+                                           kEdgeVariants * cell_size,
+                                           kAtlasRows * cell_size)) {
+  Cairo::RefPtr<Cairo::Context> cr = Cairo::Context::create(surface_);
+  cr->set_line_width(1);
+  cr->set_line_cap(Cairo::LINE_CAP_SQUARE);
+
+  DrawingDimensions dim = DrawingDimensions();
+  dim.cell_size = cell_size;
+
+  for (std::size_t atlas_row = 0; atlas_row < kAtlasRows; ++atlas_row) {
+    const Cell cell = GetAtlasCell(atlas_row);
+    for (std::size_t variant = 0; variant < kEdgeVariants; ++variant) {
+      // Any cell position not on the top or left edge draws the same way.
+      const std::size_t row = variant & 1;
+      const std::size_t col = (variant & 2) >> 1;
+
+      cr->save();
+      cr->translate(variant * cell_size, atlas_row * cell_size);
+      cr->rectangle(0.0, 0.0, cell_size, cell_size);
+      cr->clip();
+      CellDrawFlyweight(cr, dim, pixbufs, cell, row, col).Draw();
+      cr->restore();
+    }
+  }
+  surface_->flush();
+}
+
+void CellAtlas::Draw(const Cairo::RefPtr<Cairo::Context>& cr,
+                     const Cell& cell, std::size_t row, std::size_t col,
+                     double x, double y) const {
+  const double atlas_x = GetEdgeVariant(row, col) * cell_size_;
+  const double atlas_y = GetAppearance(cell) * cell_size_;
+  cr->set_source(surface_, x - atlas_x, y - atlas_y);
+  cr->rectangle(x, y, cell_size_, cell_size_);
+  cr->fill();
+}
+
+CellColorMap::CellColorMap(std::size_t rows, std::size_t cols)
+    : surface_(
+          Cairo::ImageSurface::create(Cairo::FORMAT_RGB24, cols, rows)),
+      data_(surface_->get_data()),
+      stride_(surface_->get_stride()) {
+  const std::uint32_t covered = ToPixel(kCellColor);
+  for (std::size_t row = 0; row < rows; ++row) {
+    std::uint32_t* pixels =
+        reinterpret_cast<std::uint32_t*>(data_ + row * stride_);
+    std::fill(pixels, pixels + cols, covered);
+  }
+  surface_->mark_dirty();
+}
+
+void CellColorMap::Draw(const Cell& cell, std::size_t row, std::size_t col) {
+  // The surface is never drawn to by cairo, so it needs no flush before the
+  // write, only the notification after it.
+  std::uint32_t* pixel =
+      reinterpret_cast<std::uint32_t*>(data_ + row * stride_) + col;
+  *pixel = ToPixel(GetColorMapColor(GetAppearance(cell)));
+  surface_->mark_dirty(col, row, 1, 1);
+}
+
+void DrawMineField(const Cairo::RefPtr<Cairo::Context>& cr,
+                   const DrawingDimensions& dim, const CellAtlas& atlas,
+                   const Grid<Cell>& grid, std::size_t min_row,
+                   std::size_t max_row, std::size_t min_col,
+                   std::size_t max_col) {
+  cr->save();
+  cr->translate(dim.x, dim.y);
+  DrawFrame(cr, dim);
+  cr->restore();
+
+  for (std::size_t row = min_row; row <= max_row; ++row) {
+    for (std::size_t col = min_col; col <= max_col; ++col) {
+      atlas.Draw(cr, grid(row, col), row, col, dim.GetCellX(col),
+                 dim.GetCellY(row));
+    }
+  }
+}
+
+void DrawColorMapField(const Cairo::RefPtr<Cairo::Context>& cr,
+                       const DrawingDimensions& dim,
+                       const CellColorMap& color_map) {
+  cr->save();
+  cr->translate(dim.x, dim.y);
+  DrawFrame(cr, dim);
+  cr->restore();
+
+  const Cairo::RefPtr<Cairo::ImageSurface>& surface = color_map.GetSurface();
+  Cairo::RefPtr<Cairo::SurfacePattern> pattern =
+      Cairo::SurfacePattern::create(surface);
+  // Each cell is scaled up to a solid square.
+  pattern->set_filter(Cairo::FILTER_NEAREST);
+
+  cr->save();
+  cr->translate(dim.GetCellX(0), dim.GetCellY(0));
+  cr->scale(dim.cell_size, dim.cell_size);
+  cr->set_source(pattern);
+  cr->rectangle(0.0, 0.0, surface->get_width(), surface->get_height());
+  cr->fill();
+  cr->restore();
+}
+
+}  // namespace detail
+}  // namespace ui
+}  // namespace mines
@@ -0,0 +1,150 @@
+#ifndef MINES_UI_MINE_FIELD_RENDERER_H_
+#define MINES_UI_MINE_FIELD_RENDERER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <cairomm/context.h>
+#include <cairomm/refptr.h>
+#include <cairomm/surface.h>
+#include <gdkmm/pixbuf.h>
+#include <glibmm/refptr.h>
+
+#include "mines/game/game.h"
+#include "mines/game/grid.h"
+
+namespace mines {
+namespace ui {
+
+// Drawing of the mine field, independent of the MineField widget.
+//
+// This is kept separate from the widget so that it can be exercised on an
+// offscreen surface (e.g. by benchmarks) without a display.
+namespace detail {
+
+// The size of the frame around the mine field.
+constexpr std::size_t kFrameSize = 1;
+
+// The dimensions of the actual area upon which the mine field will be drawn.
+// This is a subset of the actual allocated area.
+struct DrawingDimensions {
+  std::size_t x;
+  std::size_t y;
+  std::size_t width;
+  std::size_t height;
+  std::size_t cell_size;
+
+  // Computes the x coordinate, in pixels, of cells in the specified column.
+  std::size_t GetCellX(std::size_t col) const {
+    return x + kFrameSize + col * cell_size;
+  }
+
+  // Computes the y coordinate, in pixels, of cells in the specified row.
+  std::size_t GetCellY(std::size_t row) const {
+    return y + kFrameSize + row * cell_size;
+  }
+};
+
+// The collection of pixbufs used in the mine field.
+struct Pixbufs {
+  Glib::RefPtr<Gdk::Pixbuf> mine;
+  Glib::RefPtr<Gdk::Pixbuf> flag;
+};
+
+// A representation of the GUI's knowledge about a cell.
+//
+// The mine field animates events some time after the game sends them, so it
+// keeps its own copy of each cell rather than reading the game's player view.
+struct Cell : PlayerCell {
+  // Whether the cell should be rendered as pressed by the mouse.
+  bool pressed = false;
+};
+
+// Loads the pixbufs used to draw cells of the specified size.
+//
+// The global resources must already be registered.
+Pixbufs LoadPixbufs(std::size_t cell_size);
+
+// Pre-rendered images of every distinct cell appearance at one cell size.
+//
+// Drawing a cell from the atlas is a single blit, rather than the fills,
+// strokes and text rendering needed to draw it from scratch. The atlas only
+// needs to be rebuilt when the cell size changes.
+class CellAtlas {
+ public:
+  // Renders every cell appearance at the specified size.
+  CellAtlas(std::size_t cell_size, const Pixbufs& pixbufs);
+
+  // Returns the cell size the atlas was rendered at.
+  std::size_t GetCellSize() const { return cell_size_; }
+
+  // Draws the cell at the specified row and column, with its top left corner
+  // at x and y in the context's user space.
+  void Draw(const Cairo::RefPtr<Cairo::Context>& cr, const Cell& cell,
+            std::size_t row, std::size_t col, double x, double y) const;
+
+ private:
+  // Cells in the first row or column omit their top or left border, so each
+  // appearance is rendered in four variants.
+  static constexpr std::size_t kEdgeVariants = 4;
+
+  // Returns the atlas column holding the variant for a cell position.
+  static std::size_t GetEdgeVariant(std::size_t row, std::size_t col) {
+    return (row != 0 ? 1 : 0) | (col != 0 ? 2 : 0);
+  }
+
+  const std::size_t cell_size_;
+
+  // Appearances are laid out one per row, with the edge variants in columns.
+  Cairo::RefPtr<Cairo::ImageSurface> surface_;
+};
+
+// A rendering of the mine field with a single pixel per cell.
+//
+// Cells too small to show their contents are drawn by scaling this up, so the
+// cost of drawing depends on the area drawn rather than the number of cells,
+// and updating a cell is a single pixel write.
+class CellColorMap {
+ public:
+  // Creates a color map with the specified number of rows and columns, in
+  // which every cell is covered.
+  CellColorMap(std::size_t rows, std::size_t cols);
+
+  // Updates the pixel for the cell at the specified row and column.
+  void Draw(const Cell& cell, std::size_t row, std::size_t col);
+
+  // Returns the surface holding the map, with the pixel for each cell at its
+  // row and column.
+  const Cairo::RefPtr<Cairo::ImageSurface>& GetSurface() const {
+    return surface_;
+  }
+
+ private:
+  Cairo::RefPtr<Cairo::ImageSurface> surface_;
+
+  // The pixels of surface_, written directly.
+  unsigned char* data_;
+  std::size_t stride_;
+};
+
+// Draws the frame and the cells in rows [min_row, max_row] and columns
+// [min_col, max_col].
+void DrawMineField(const Cairo::RefPtr<Cairo::Context>& cr,
+                   const DrawingDimensions& dim, const CellAtlas& atlas,
+                   const Grid<Cell>& grid, std::size_t min_row,
+                   std::size_t max_row, std::size_t min_col,
+                   std::size_t max_col);
+
+// Draws the frame and the color map, scaled so that each cell fills a square
+// of dim.cell_size pixels. Only the part of the map within the clip region is
+// rasterized.
+void DrawColorMapField(const Cairo::RefPtr<Cairo::Context>& cr,
+                       const DrawingDimensions& dim,
+                       const CellColorMap& color_map);
+
+}  // namespace detail
+
+}  // namespace ui
+}  // namespace mines
+
+#endif  // MINES_UI_MINE_FIELD_RENDERER_H_
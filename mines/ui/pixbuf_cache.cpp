@@ -0,0 +1,51 @@
+#include "mines/ui/pixbuf_cache.h"
+
+#include <list>
+#include <string>
+
+#include "mines/compat/gdk_pixbuf.h"
+
+namespace mines {
+namespace ui {
+
+namespace {
+
+// A rasterized resource.
+struct Entry {
+  std::string resource_path;
+  int width;
+  int height;
+  Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+};
+
+// The cached entries, most recently used first. The cache is small enough that
+// a linear search is cheaper than rasterizing even the smallest SVG.
+std::list<Entry>& GetEntries() {
+  static std::list<Entry> entries;
+  return entries;
+}
+
+}  // namespace
+
+Glib::RefPtr<Gdk::Pixbuf> GetCachedPixbuf(const char* resource_path, int width,
+                                          int height) {
+  std::list<Entry>& entries = GetEntries();
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    if (it->width == width && it->height == height &&
+        it->resource_path == resource_path) {
+      entries.splice(entries.begin(), entries, it);
+      return it->pixbuf;
+    }
+  }
+
+  Glib::RefPtr<Gdk::Pixbuf> pixbuf =
+      compat::CreatePixbufFromResource(resource_path, width, height);
+  entries.push_front(Entry{resource_path, width, height, pixbuf});
+  if (entries.size() > kPixbufCacheCapacity) {
+    entries.pop_back();
+  }
+  return pixbuf;
+}
+
+}  // namespace ui
+}  // namespace mines
@@ -0,0 +1,29 @@
+#ifndef MINES_UI_PIXBUF_CACHE_H_
+#define MINES_UI_PIXBUF_CACHE_H_
+
+#include <cstddef>
+
+#include <gdkmm/pixbuf.h>
+#include <glibmm/refptr.h>
+
+namespace mines {
+namespace ui {
+
+// The number of rasterized resources kept by the pixbuf cache.
+constexpr std::size_t kPixbufCacheCapacity = 64;
+
+// Returns the specified global resource rasterized at the specified size.
+//
+// The result is shared by every caller in the process, so the pixbuf must not
+// be modified. The most recently used kPixbufCacheCapacity resource and size
+// combinations are kept, so that widgets being realized again, or a window
+// being resized back and forth, do not rasterize the same SVG repeatedly.
+//
+// Must only be called from the main thread.
+Glib::RefPtr<Gdk::Pixbuf> GetCachedPixbuf(const char* resource_path, int width,
+                                          int height);
+
+}  // namespace ui
+}  // namespace mines
+
+#endif  // MINES_UI_PIXBUF_CACHE_H_
@@ -4,7 +4,7 @@
 
 #include <sigc++/functors/mem_fun.h>
 
-#include "mines/compat/gdk_pixbuf.h"
+#include "mines/ui/pixbuf_cache.h"
 
 namespace mines {
 namespace ui {
@@ -43,18 +43,16 @@ ResetButton::ResetButton(BaseObjectType* cobj,
 }
 
 void ResetButton::on_realize() {
-  using compat::CreatePixbufFromResource;
-
   Gtk::Button::on_realize();
 
-  smiley_happy_.set(CreatePixbufFromResource(kSmileyHappyResourcePath,
-                                             kPixbufSize, kPixbufSize));
-  smiley_cry_.set(CreatePixbufFromResource(kSmileyCryResourcePath, kPixbufSize,
-                                           kPixbufSize));
-  smiley_cool_.set(CreatePixbufFromResource(kSmileyCoolResourcePath,
-                                            kPixbufSize, kPixbufSize));
-  smiley_scared_.set(CreatePixbufFromResource(kSmileyScaredResourcePath,
-                                              kPixbufSize, kPixbufSize));
+  smiley_happy_.set(
+      GetCachedPixbuf(kSmileyHappyResourcePath, kPixbufSize, kPixbufSize));
+  smiley_cry_.set(
+      GetCachedPixbuf(kSmileyCryResourcePath, kPixbufSize, kPixbufSize));
+  smiley_cool_.set(
+      GetCachedPixbuf(kSmileyCoolResourcePath, kPixbufSize, kPixbufSize));
+  smiley_scared_.set(
+      GetCachedPixbuf(kSmileyScaredResourcePath, kPixbufSize, kPixbufSize));
 }
 
 void ResetButton::NotifyEventSubscription(Game* game) {
@@ -0,0 +1,118 @@
+#include "mines/ui/solver_worker.h"
+
+#include <chrono>
+#include <utility>
+
+#include <sigc++/functors/mem_fun.h>
+
+namespace mines {
+namespace ui {
+
+namespace {
+
+// The longest the solver runs before checking for cancellation. Actions found
+// within a slice are delivered as soon as it ends.
+constexpr std::chrono::milliseconds kAnalyzeSlice(10);
+
+}  // namespace
+
+SolverWorker::SolverWorker(std::unique_ptr<solver::Solver> solver)
+    : solver_(std::move(solver)) {
+  dispatcher_.connect(sigc::mem_fun(*this, &SolverWorker::OnResult));
+  thread_ = std::thread(&SolverWorker::Run, this);
+}
+
+SolverWorker::~SolverWorker() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+void SolverWorker::Analyze() {
+  cancelled_ = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requested_ = true;
+    paused_ = false;
+  }
+  wake_.notify_one();
+}
+
+void SolverWorker::Cancel() {
+  cancelled_ = true;
+  std::lock_guard<std::mutex> lock(mutex_);
+  paused_ = true;
+}
+
+solver::SolverCounters SolverWorker::GetCounters() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return counters_;
+}
+
+void SolverWorker::NotifyEvent(const Event& event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.push_back(event);
+}
+
+void SolverWorker::Run() {
+  std::vector<Event> events;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this] { return stopping_ || requested_; });
+      if (stopping_) {
+        return;
+      }
+      requested_ = false;
+      events.swap(events_);
+    }
+
+    for (const Event& event : events) {
+      solver_->NotifyEvent(event);
+    }
+    events.clear();
+    std::vector<Action> actions;
+    const solver::AnalyzeStatus status = solver_->Analyze(
+        solver::AnalyzeBudget::For(kAnalyzeSlice), &actions);
+    const bool incomplete = status == solver::AnalyzeStatus::INCOMPLETE;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // The main thread may not have taken the previous result yet.
+      result_.insert(result_.end(), actions.begin(), actions.end());
+      counters_ = solver_->GetCounters();
+      if (incomplete && !paused_) {
+        requested_ = true;
+      }
+    }
+    // An incomplete analysis with nothing to show is not a result: an empty
+    // result would tell the owner that the solver is stuck.
+    if (!incomplete || !actions.empty()) {
+      dispatcher_.emit();
+    }
+  }
+}
+
+void SolverWorker::OnResult() {
+  std::vector<Action> actions;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    actions.swap(result_);
+  }
+
+  if (cancelled_) {
+    deferred_.insert(deferred_.end(), actions.begin(), actions.end());
+    return;
+  }
+  if (!deferred_.empty()) {
+    actions.insert(actions.begin(), deferred_.begin(), deferred_.end());
+    deferred_.clear();
+  }
+  signal_actions_.emit(actions);
+}
+
+}  // namespace ui
+}  // namespace mines
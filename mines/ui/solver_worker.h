@@ -0,0 +1,124 @@
+#ifndef MINES_UI_SOLVER_WORKER_H_
+#define MINES_UI_SOLVER_WORKER_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glibmm/dispatcher.h>
+#include <sigc++/signal.h>
+
+#include "mines/game/game.h"
+#include "mines/solver/solver.h"
+
+namespace mines {
+namespace ui {
+
+// Runs a solver on a background thread so that the main loop stays responsive
+// during a long analysis.
+//
+// The game stays on the main thread. The worker is subscribed to the game in
+// place of the solver and queues its events; they are passed to the solver on
+// the worker thread before each analysis, so the solver is only ever touched
+// by that thread. Recommended actions are sent back to the main thread, where
+// the owner executes them.
+//
+// Actions recommended while the user is also playing may be redundant by the
+// time they are executed. The game ignores redundant uncovers, and a redundant
+// flag is corrected by the solver when it sees the resulting UNFLAG event.
+class SolverWorker : public EventSubscriber {
+ public:
+  // Starts a worker thread for the solver, which must not be subscribed to a
+  // game (see solver::NewUnsubscribed).
+  explicit SolverWorker(std::unique_ptr<solver::Solver> solver);
+
+  // Stops the worker thread, waiting for any analysis in progress to finish.
+  ~SolverWorker() final;
+
+  // Requests that the solver analyze every event received so far.
+  //
+  // signal_actions is emitted on the main thread with the result. Requests
+  // made while an analysis is in progress are combined into one further
+  // analysis. Also resumes delivery of results after Cancel.
+  void Analyze();
+
+  // Stops delivering results until the next call to Analyze.
+  //
+  // The solver is analyzed in short slices, so an analysis in progress stops
+  // at the end of the current slice and resumes with the next call to
+  // Analyze. Actions it already produced are held back and delivered ahead of
+  // the next result, because solvers expect their recommendations to be
+  // executed eventually.
+  void Cancel();
+
+  // Returns a copy of the solver's counters as of the end of the most recent
+  // analysis.
+  solver::SolverCounters GetCounters() const;
+
+  // The signal emitted on the main thread when an analysis completes.
+  //
+  // An empty vector means the solver can make no progress.
+  sigc::signal<void, const std::vector<Action>&>& signal_actions() {
+    return signal_actions_;
+  }
+
+  // Queues the event for the solver.
+  void NotifyEvent(const Event& event) final;
+
+ private:
+  // The body of the worker thread.
+  void Run();
+
+  // Delivers completed results on the main thread.
+  void OnResult();
+
+  // The solver, only used by the worker thread.
+  const std::unique_ptr<solver::Solver> solver_;
+
+  // Guards the members shared between the threads, below.
+  mutable std::mutex mutex_;
+
+  // Wakes the worker thread when analysis is requested or it must stop.
+  std::condition_variable wake_;
+
+  // Events not yet passed to the solver.
+  std::vector<Event> events_;
+
+  // True if an analysis has been requested and not yet started.
+  bool requested_ = false;
+
+  // True if the worker thread must exit.
+  bool stopping_ = false;
+
+  // True if an incomplete analysis must wait for the next request rather than
+  // continuing with another slice.
+  bool paused_ = false;
+
+  // Actions produced by the worker thread and not yet taken by OnResult.
+  std::vector<Action> result_;
+
+  // The solver's counters as of the end of the most recent analysis.
+  solver::SolverCounters counters_;
+
+  // Main thread state: whether results are being held back, and the held
+  // back actions.
+  bool cancelled_ = false;
+  std::vector<Action> deferred_;
+
+  // Wakes the main loop when a result is ready.
+  Glib::Dispatcher dispatcher_;
+
+  // Signal emitted when an analysis completes.
+  sigc::signal<void, const std::vector<Action>&> signal_actions_;
+
+  // The worker thread. Declared last so that it starts after, and is joined
+  // before, everything it uses.
+  std::thread thread_;
+};
+
+}  // namespace ui
+}  // namespace mines
+
+#endif  // MINES_UI_SOLVER_WORKER_H_
@@ -91,6 +91,8 @@ class MinesApplication : public Gtk::Application {
       difficulty_ = GameWindow::kBeginnerDifficulty;
     } else if (target == "intermediate") {
       difficulty_ = GameWindow::kIntermediateDifficulty;
+    } else if (target == "huge") {
+      difficulty_ = GameWindow::kHugeDifficulty;
     } else {
       difficulty_ = GameWindow::kExpertDifficulty;
     }